@@ -3,8 +3,33 @@
 # this is "good enough" for my comfy development platform, but it's rough for
 # everyone else. before turning in the project i need to convert this to a
 # vs2019 project or smth.
-g++ main.cpp -o blah.exe \
+#
+# (CMakeLists.txt does all of this too, plus LTO and a PGO build; see
+# tools/pgo.sh.)
+
+# EMBED=1 ./build.sh bakes the assets into the game, so it starts up
+# without reading any files (and from any directory).
+EMBED_FLAGS=""
+if [ "$EMBED" = 1 ]; then
+	g++ -O2 tools/embed.cpp -o embed.exe
+	./embed.exe frontend/embedded_assets.hpp \
+		ASSET_TILES_PNG      images/tiles.png \
+		ASSET_BACKGROUND_PNG images/background.png \
+		ASSET_FRAME_PNG      images/frame.png \
+		ASSET_COMIC_TTF      images/comic.ttf || exit 1
+	EMBED_FLAGS="-D EMBED_ASSETS"
+fi
+
+g++ main.cpp -o blah.exe -pthread $EMBED_FLAGS \
 	-D SFML_STATIC \
 	-lsfml-graphics-s -lsfml-window-s -lsfml-audio-s -lsfml-system-s \
 	-lopenal -lflac -lvorbisenc -lvorbisfile -lvorbis -logg \
-	-lgdi32 -lopengl32 -lfreetype -lwinmm
+	-lgdi32 -lopengl32 -lfreetype -lwinmm -lws2_32
+
+# Headless tools. These don't touch SFML at all.
+g++ -O2 tools/runner.cpp -o runner.exe -pthread
+g++ -O2 tools/replaycheck.cpp -o replaycheck.exe -pthread
+g++ -O2 tools/netplay.cpp -o netplay.exe -lws2_32
+g++ -O2 tools/corecheck.cpp -o corecheck.exe
+# (-march=native turns on AVX2 for the board evaluation kernel, where there is any.)
+g++ -O2 -march=native tools/bench.cpp -o bench.exe -pthread
@@ -0,0 +1,80 @@
+// Guideline Tetris!!
+// Optional global allocation counter, for catching heap use in the frame loop.
+
+// Build with `-D TETRIS_COUNT_ALLOCATIONS` (or CMake's
+// `-D TETRIS_COUNT_ALLOCATIONS=ON`) to turn it on. That replaces the
+// global operator new and delete, so only include this from the file that
+// has `main()` in it. With it off, this costs nothing at all.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+	#include <malloc.h> // _aligned_malloc
+#endif
+
+#ifdef TETRIS_COUNT_ALLOCATIONS
+
+const bool COUNTING_ALLOCATIONS = true;
+
+std::atomic<long int> allocationCount { 0 };
+
+// How many times anything has been allocated since the program started.
+long int getAllocationCount() {
+	return allocationCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// And the over-aligned kind, for `alignas(64)` things like
+// TranspositionTable's buckets. (Windows has no aligned_alloc, and memory from
+// its _aligned_malloc has to go back through _aligned_free.)
+void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	std::size_t align = (std::size_t)alignment;
+	std::size_t rounded = size ? (size + align - 1) / align * align : align; // aligned_alloc wants a multiple
+#ifdef _WIN32
+	if (void* p = _aligned_malloc(rounded, align)) return p;
+#else
+	if (void* p = std::aligned_alloc(align, rounded)) return p;
+#endif
+	throw std::bad_alloc();
+}
+
+void freeAligned(void* p) noexcept {
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+
+#else
+
+const bool COUNTING_ALLOCATIONS = false;
+
+inline long int getAllocationCount() { return 0; }
+
+#endif
@@ -0,0 +1,333 @@
+// Guideline Tetris!!
+// The board: a grid of tiles that pieces get written into.
+
+#pragma once
+
+#include "vec.hpp"
+#include "zobrist.hpp"
+
+#include <cstdint>
+#include <utility>
+
+// Which lines got cleared, all at once.
+struct LineClear {
+	int count = 0;
+	
+	// Bit y is set if row y was cleared. (Rows are numbered from before the
+	// clear, so this is where the lines were, not where things are now.)
+	uint32_t rows = 0;
+	
+	bool isCleared(int y) const { return rows >> y & 1; }
+};
+
+struct Board {
+	const static int WIDTH  = 10;
+	const static int HEIGHT = 32;
+	
+	// The Tetris Guidelines say your board needs to have space beyond the top,
+	// but still look like it's 20 tiles tall. It's a neat mechanic! If you try
+	// hard enough, you can roll pieces around up to the 24th row and save
+	// yourself from game overs!
+	const static int VISIBLE_HEIGHT = 20;
+	
+	const static int TILE_SIZE = 18;
+	
+	// The board's position on the screen.
+	static constexpr std::pair<int, int> POSITION = { 28, 31 };
+	
+	// Occupancy bitboard, kept in sync with `board` below.
+	// Column x of a row lives at bit (x + WALL_BITS). The bits either side of
+	// the columns are always set, so they act as the walls, and a couple of
+	// completely set rows above and below the board act as the ceiling and
+	// floor. Collision checks become a few shifts and ANDs.
+	const static int WALL_BITS = 3;
+	const static int SENTINEL_ROWS = 2;
+	const static uint16_t FULL_ROW  = 0xFFFF;
+	const static uint16_t EMPTY_ROW = FULL_ROW & ~(((1 << WIDTH) - 1) << WALL_BITS);
+	
+	uint16_t rows[HEIGHT + SENTINEL_ROWS * 2];
+	static_assert(HEIGHT <= 32, "LineClear::rows needs a bit per row");
+	
+	// Zobrist hash of which tiles are filled (see zobrist.hpp), kept up to
+	// date by everything that changes them.
+	uint64_t hash = 0;
+	static_assert(HEIGHT == zobrist::ROWS && WIDTH == zobrist::COLUMNS, "zobrist keys don't fit the board");
+	
+	// At the start of the game, the board is filled with empty tiles.
+	// (This is just the tile colors now; it's only used for drawing.
+	// A byte each is plenty, and keeps game snapshots small.)
+	uint8_t board[HEIGHT][WIDTH] = { 0 };
+	
+	// Running stats about the tiles, kept up to date by `setTile`,
+	// `removeLine` and `clear`, so asking about them never means a rescan.
+	int columnHeights[WIDTH]; // one above each column's highest tile (0 if empty)
+	int rowFills[HEIGHT];     // how many tiles are in each row
+	int maxHeight;            // the tallest column's height
+	int heightSum;            // every column's height, added up
+	int tileCount;            // how many tiles there are in total
+	
+	Board() { clear(); }
+	
+	// Clears board of all tiles.
+	void clear() {
+		for (int j = 0; j < HEIGHT; j++)
+			for (int i = 0; i < WIDTH; i++)
+				board[j][i] = 0;
+		
+		for (int i = 0; i < WIDTH; i++)
+			columnHeights[i] = 0;
+		for (int j = 0; j < HEIGHT; j++)
+			rowFills[j] = 0;
+		maxHeight = heightSum = tileCount = 0;
+		hash = 0;
+		
+		for (int j = 0; j < SENTINEL_ROWS; j++) {
+			rows[j] = FULL_ROW;
+			rows[SENTINEL_ROWS + HEIGHT + j] = FULL_ROW;
+		}
+		for (int j = 0; j < HEIGHT; j++)
+			rows[SENTINEL_ROWS + j] = EMPTY_ROW;
+	}
+	
+	// Returns the occupancy mask of a row, including the walls.
+	// Valid from `-SENTINEL_ROWS` up to `HEIGHT + SENTINEL_ROWS - 1`.
+	uint16_t getRowMask(int y) const {
+		return rows[y + SENTINEL_ROWS];
+	}
+	
+	// Removes all lines that are filled with non-zero tiles.
+	// Returns how many lines were cleared.
+	int removeFilledLines() {
+		return clearLines(0, HEIGHT - 1).count;
+	}
+	
+	// Removes the filled lines from `bottom` to `top` (inclusive). Only new
+	// tiles can fill a line, so that only has to be the rows a piece just
+	// landed on.
+	// It's all one pass: every row above the lowest cleared one moves down
+	// at most once, however many lines go.
+	LineClear clearLines(int bottom, int top) {
+		LineClear cleared;
+		if (bottom < 0) bottom = 0;
+		if (top >= HEIGHT) top = HEIGHT - 1;
+		
+		int lowest = -1, highest = -1;
+		for (int y = bottom; y <= top; y++) {
+			if (getRowMask(y) != FULL_ROW) continue;
+			cleared.rows |= 1u << y;
+			cleared.count++;
+			if (lowest < 0) lowest = y;
+			highest = y;
+		}
+		if (cleared.count == 0) return cleared;
+		
+		// Slide every surviving row down over the cleared ones. Nothing's
+		// above the tallest column, so there's no need to go any further.
+		int to = lowest;
+		for (int from = lowest + 1; from < maxHeight; from++)
+			if (!cleared.isCleared(from))
+				moveRow(from, to++);
+		for (; to < maxHeight; to++)
+			emptyRow(to);
+		
+		tileCount -= cleared.count * WIDTH;
+		
+		// A full line goes through every column, so every column had all of
+		// the cleared lines below its top. Columns that topped out on the
+		// highest one have to look for their next tile down.
+		maxHeight = heightSum = 0;
+		for (int i = 0; i < WIDTH; i++) {
+			int& height = columnHeights[i];
+			bool topCleared = height == highest + 1;
+			height -= cleared.count;
+			if (topCleared) height = findColumnHeight(i, height);
+			
+			heightSum += height;
+			if (height > maxHeight) maxHeight = height;
+		}
+		
+		return cleared;
+	}
+	
+	// Checks if a line of the board is filled.
+	bool isLineFilled(int y) const {
+		if (y < 0) return true;
+		if (y >= HEIGHT) return false;
+		
+		return getRowMask(y) == FULL_ROW;
+	}
+	
+	// How many tiles are in a row.
+	int getRowFill(int y) const { return rowFills[y]; }
+	
+	// One above the highest tile in a column, or 0 if it's empty.
+	int getColumnHeight(int x) const { return columnHeights[x]; }
+	
+	// The tallest column's height.
+	int getMaxHeight() const { return maxHeight; }
+	
+	// Every column's height, added up.
+	int getHeightSum() const { return heightSum; }
+	
+	// Empty tiles with something above them, somewhere in their column.
+	// (Every tile below a column's height is either filled or a hole.)
+	int getHoleCount() const { return heightSum - tileCount; }
+	
+	// Removes a line from the board, bringing lines above it down too.
+	void removeLine(int y) {
+		if (y < 0 || y >= HEIGHT) return;
+		
+		tileCount -= rowFills[y];
+		
+		// Shift lines above this line downwards.
+		for (int j = y + 1; j < HEIGHT; j++)
+			moveRow(j, j - 1);
+		
+		// Clear topmost line
+		// (did you know? some official tetris games screw this up!)
+		// https://youtu.be/9X2AYnr2XaQ?t=61 (look at minimap of left board)
+		emptyRow(HEIGHT - 1);
+		
+		// Columns that went above the line just drop by one. Columns that
+		// topped out right on it have to look for their next tile down.
+		maxHeight = heightSum = 0;
+		for (int i = 0; i < WIDTH; i++) {
+			int& height = columnHeights[i];
+			if (height > y + 1) height--;
+			else if (height == y + 1) height = findColumnHeight(i, y);
+			
+			heightSum += height;
+			if (height > maxHeight) maxHeight = height;
+		}
+	}
+	
+	// Pushes everything up by `count` rows of garbage: full rows, except for
+	// an empty tile in column `hole`. Anything pushed out of the top is gone.
+	// Returns true if that happened (which tops the board out).
+	bool addGarbage(int count, int hole, int color) {
+		if (count <= 0) return false;
+		if (count > HEIGHT) count = HEIGHT;
+		
+		bool toppedOut = maxHeight + count > HEIGHT;
+		for (int j = HEIGHT - count; j < maxHeight; j++)
+			tileCount -= rowFills[j];
+		
+		// Nothing's above the tallest column, so only that much has to move.
+		int top = maxHeight + count;
+		if (top > HEIGHT) top = HEIGHT;
+		for (int to = top - 1; to >= count; to--)
+			moveRow(to - count, to);
+		
+		uint16_t garbageRow = FULL_ROW & ~(1 << (hole + WALL_BITS));
+		for (int j = 0; j < count; j++) {
+			for (int i = 0; i < WIDTH; i++)
+				board[j][i] = i == hole ? 0 : color;
+			hash ^= getRowKey(j);
+			rows[SENTINEL_ROWS + j] = garbageRow;
+			hash ^= getRowKey(j);
+			rowFills[j] = WIDTH - 1;
+		}
+		tileCount += count * (WIDTH - 1);
+		
+		// Every column goes up by `count`, except an empty one under the hole.
+		// Columns that went through the ceiling have to look for their new top.
+		maxHeight = heightSum = 0;
+		for (int i = 0; i < WIDTH; i++) {
+			int& height = columnHeights[i];
+			if (height > 0 || i != hole) height += count;
+			if (height > HEIGHT) height = findColumnHeight(i, HEIGHT);
+			
+			heightSum += height;
+			if (height > maxHeight) maxHeight = height;
+		}
+		
+		return toppedOut;
+	}
+	
+	// Checks if a position is on the board.
+	bool isOnBoard(const Vec2i& v) const {
+		return v.x >= 0 && v.x < WIDTH && v.y >= 0 && v.y < HEIGHT;
+	}
+	
+	// Returns the bounds-checked tile at the supplied position.
+	int getTile(const Vec2i& v) const {
+		if (isOnBoard(v)) return board[v.y][v.x];
+		return 1;
+	}
+	
+	// Sets the tile at the specified position, only if the position is valid.
+	void setTile(const Vec2i& v, int color) {
+		if (!isOnBoard(v)) return;
+		
+		bool wasFilled = board[v.y][v.x] != 0;
+		board[v.y][v.x] = color;
+		
+		uint16_t bit = 1 << (v.x + WALL_BITS);
+		if (color != 0) rows[SENTINEL_ROWS + v.y] |=  bit;
+		else            rows[SENTINEL_ROWS + v.y] &= ~bit;
+		
+		if (wasFilled == (color != 0)) return;
+		hash ^= zobrist::tile(v.y, v.x);
+		
+		if (color != 0) {
+			rowFills[v.y]++;
+			tileCount++;
+			if (v.y >= columnHeights[v.x])
+				setColumnHeight(v.x, v.y + 1);
+		} else {
+			rowFills[v.y]--;
+			tileCount--;
+			if (v.y + 1 == columnHeights[v.x])
+				setColumnHeight(v.x, findColumnHeight(v.x, v.y));
+		}
+	}
+
+private:
+	// Copies a row (tiles, mask, fill count and hash) over another one.
+	void moveRow(int from, int to) {
+		for (int i = 0; i < WIDTH; i++)
+			board[to][i] = board[from][i];
+		hash ^= getRowKey(to);
+		rows[SENTINEL_ROWS + to] = rows[SENTINEL_ROWS + from];
+		hash ^= getRowKey(to);
+		rowFills[to] = rowFills[from];
+	}
+	
+	void emptyRow(int y) {
+		for (int i = 0; i < WIDTH; i++)
+			board[y][i] = 0;
+		hash ^= getRowKey(y);
+		rows[SENTINEL_ROWS + y] = EMPTY_ROW;
+		rowFills[y] = 0;
+	}
+	
+	// The Zobrist keys of every tile filled in a row, all together.
+	uint64_t getRowKey(int y) const {
+		return zobrist::row(y, (getRowMask(y) >> WALL_BITS) & ((1 << WIDTH) - 1));
+	}
+	
+	// Finds the height of a column, only looking at tiles below row `below`.
+	int findColumnHeight(int x, int below) const {
+		uint16_t bit = 1 << (x + WALL_BITS);
+		for (int j = below - 1; j >= 0; j--)
+			if (getRowMask(j) & bit)
+				return j + 1;
+		return 0;
+	}
+	
+	void setColumnHeight(int x, int height) {
+		int oldHeight = columnHeights[x];
+		columnHeights[x] = height;
+		heightSum += height - oldHeight;
+		
+		if (height > maxHeight) {
+			maxHeight = height;
+		} else if (oldHeight == maxHeight) {
+			// This was (one of) the tallest, so it might not be anymore.
+			maxHeight = 0;
+			for (int i = 0; i < WIDTH; i++)
+				if (columnHeights[i] > maxHeight)
+					maxHeight = columnHeights[i];
+		}
+	}
+};
@@ -0,0 +1,143 @@
+// Guideline Tetris!!
+// A very simple computer player, so games can run without a human around.
+
+#pragma once
+
+#include "board.hpp"
+#include "evaluate.hpp"
+#include "game.hpp"
+#include "piece.hpp"
+
+// For each new piece, the bot tries every rotation and column, drops the
+// piece there on a scratch board and scores the results, a batch at a
+// time (see evaluate.hpp). Then it presses
+// buttons to get to the best spot, one step at a time, like a person would.
+struct Bot {
+	EvalWeights weights = NEAR_PERFECT_WEIGHTS;
+	
+	// Which piece (counted by `Game::pieces`) the current plan is for.
+	long int plannedFor = -1;
+	
+	int targetRotation = 0;
+	int targetX = 0;
+	
+	// Gives up and hard drops if a plan takes way too long to carry out.
+	static const int MAX_STEPS_PER_PIECE = 60;
+	int stepsTaken = 0;
+	
+	// Decides what buttons to press this step.
+	InputFrame think(const Game& game) {
+		InputFrame input;
+		
+		if (game.gameOver) {
+			plannedFor = -1;
+			return input;
+		}
+		
+		if (plannedFor != game.pieces) plan(game);
+		
+		const Piece& piece = game.piece;
+		if (piece.rotation != targetRotation) {
+			input.rotate = ((targetRotation - piece.rotation) & 3) == 3 ? -1 : +1;
+		} else if (piece.position.x != targetX) {
+			int dx = piece.position.x < targetX ? +1 : -1;
+			if (piece.fits(game.board, { dx, 0 })) input.dx = dx;
+			else input.hardDrop = true;
+		} else {
+			input.hardDrop = true;
+		}
+		
+		if (++stepsTaken > MAX_STEPS_PER_PIECE) input.hardDrop = true;
+		
+		return input;
+	}
+	
+	// Picks a rotation and column for the current piece.
+	void plan(const Game& game) {
+		Drop best = findBestDrop(game.board, game.piece, weights);
+		if (best.found) follow(game, best.rotation, best.x);
+		else follow(game, game.piece.rotation, game.piece.position.x);
+	}
+	
+	// Goes for a spot somebody else picked for the current piece (like
+	// MonteCarloPlanner), instead of planning one.
+	void follow(const Game& game, int rotation, int x) {
+		plannedFor = game.pieces;
+		stepsTaken = 0;
+		targetRotation = rotation;
+		targetX = x;
+	}
+	
+	// A spot to hard drop a piece into, and how good the board is after.
+	struct Drop {
+		bool found = false;
+		int rotation = 0, x = 0;
+		Piece piece;     // already dropped there
+		float score = 0; // with the lines it clears
+	};
+	
+	// Calls `fn(dropped, rotation, x)` for every spot the piece can be hard
+	// dropped into, getting there the way `think` would (rotating first,
+	// then shifting over).
+	template<typename F>
+	static void forEachDrop(const Board& board, const Piece& piece, F fn) {
+		for (int r = 0; r < 4; r++) {
+			// Rotate the same way `think` will.
+			Piece rotated = piece;
+			while (rotated.rotation != r) {
+				int direction = ((r - rotated.rotation) & 3) == 3 ? -1 : +1;
+				if (!rotated.rotate(board, direction)) break;
+			}
+			if (rotated.rotation != r) continue;
+			
+			for (int x = 0; x < Board::WIDTH; x++) {
+				Piece moved = rotated;
+				int dx = x < moved.position.x ? -1 : +1;
+				while (moved.position.x != x && moved.fits(board, { dx, 0 }))
+					moved.position.x += dx;
+				if (moved.position.x != x) continue;
+				
+				moved.position.y = moved.getDropYCoord(board);
+				fn(moved, r, x);
+			}
+		}
+	}
+	
+	// Drops the piece onto a copy of the board in every spot it can go,
+	// and picks the best board.
+	static Drop findBestDrop(const Board& board, const Piece& piece, const EvalWeights& weights) {
+		Drop best;
+		
+		// Candidates get scored 16 at a time, so remember where each one was.
+		BoardBatch batch;
+		Drop candidates[BoardBatch::LANES];
+		float scores[BoardBatch::LANES];
+		
+		auto scoreCandidates = [&]() {
+			scoreBatch(batch, weights, scores);
+			for (int i = 0; i < batch.count; i++) {
+				if (!best.found || scores[i] > best.score) {
+					best = candidates[i];
+					best.found = true;
+					best.score = scores[i];
+				}
+			}
+			batch.clear();
+		};
+		
+		forEachDrop(board, piece, [&](const Piece& dropped, int rotation, int x) {
+			Board scratch = board;
+			dropped.place(scratch);
+			int cleared = scratch.clearLines(dropped.position.y - PIECE_REACH, dropped.position.y + PIECE_REACH).count;
+			
+			Drop& candidate = candidates[batch.add(scratch, cleared)];
+			candidate.rotation = rotation;
+			candidate.x = x;
+			candidate.piece = dropped;
+			if (batch.isFull()) scoreCandidates();
+		});
+		
+		if (batch.count > 0) scoreCandidates();
+		return best;
+	}
+};
@@ -0,0 +1,219 @@
+// Guideline Tetris!!
+// Scores lots of candidate boards at once, for the bot.
+
+#pragma once
+
+#include "board.hpp"
+
+#include <cstdint>
+
+#ifdef __AVX2__
+	#include <immintrin.h>
+#endif
+
+// How much each feature of a board is worth. Higher scores are better,
+// so the bad stuff gets negative weights.
+struct EvalWeights {
+	float height;         // column heights, all added up
+	float lines;          // lines cleared getting to this board
+	float holes;          // empty tiles with something above them
+	float bumpiness;      // height differences between neighboring columns
+	float wells;          // empty tiles above the stack with both sides filled
+	float rowTransitions; // filled/empty changes along each row (walls count as filled)
+};
+
+// Weights from the "near perfect player":
+// https://codemyroad.wordpress.com/2013/04/14/tetris-ai-the-near-perfect-player/
+// (Wells and row transitions aren't used by those.)
+constexpr EvalWeights NEAR_PERFECT_WEIGHTS = {
+	-0.510066, // height
+	+0.760666, // lines
+	-0.35663,  // holes
+	-0.184483, // bumpiness
+	0,         // wells
+	0,         // row transitions
+};
+
+// Up to LANES boards, stored row-major and candidate-minor ("structure of
+// arrays"): `rows[y]` is row y of every board side by side, so one row of
+// all 16 boards is exactly one AVX2 register.
+struct BoardBatch {
+	static const int LANES = 16;
+	
+	alignas(32) uint16_t rows[Board::HEIGHT][LANES];
+	alignas(32) int32_t linesCleared[LANES];
+	int count = 0;
+	
+	// The highest row that isn't empty in at least one lane.
+	// Everything above it is empty everywhere, so scoring can skip it.
+	int topRow = Board::HEIGHT - 1;
+	
+	BoardBatch() { clear(); }
+	
+	// Empties every lane, so unused lanes still hold sensible (empty) boards.
+	void clear() {
+		for (int y = 0; y <= topRow; y++)
+			for (int i = 0; i < LANES; i++)
+				rows[y][i] = Board::EMPTY_ROW;
+		for (int i = 0; i < LANES; i++)
+			linesCleared[i] = 0;
+		count = 0;
+		topRow = -1;
+	}
+	
+	bool isFull() const { return count == LANES; }
+	
+	// Adds a board to the next lane. Returns which lane that was.
+	int add(const Board& board, int lines) {
+		int lane = count++;
+		for (int y = 0; y < Board::HEIGHT; y++) {
+			uint16_t row = board.getRowMask(y);
+			rows[y][lane] = row;
+			if (row != Board::EMPTY_ROW && y > topRow) topRow = y;
+		}
+		linesCleared[lane] = lines;
+		return lane;
+	}
+};
+
+// All of the features get worked out a row at a time, from the top down,
+// with nothing but bit tricks on the row masks (walls included):
+//
+//   `covered` is every row above this one ORed together, `seen` is the same
+//   but including this row. So a column is in `seen` exactly for the rows
+//   below its top, which means:
+//
+//   height      = popcount(seen), summed over rows
+//   holes       = popcount(covered & ~row)
+//   bumpiness   = popcount(seen ^ (seen >> 1)), for each pair of columns
+//   wells       = popcount(~seen & (seen << 1) & (seen >> 1))
+//   transitions = popcount(row ^ (row >> 1)), from the left wall to the right
+//
+// Rows above `BoardBatch::topRow` are empty everywhere, so each of them is
+// just the two transitions next to the walls, and can be skipped.
+namespace evaluate {
+	const uint16_t COLUMNS = Board::FULL_ROW & ~Board::EMPTY_ROW;
+	
+	// Pairs of neighboring columns, by the lower column's bit.
+	const uint16_t COLUMN_PAIRS = COLUMNS & (COLUMNS >> 1);
+	
+	// Neighboring tiles from the left wall to the right one, by the lower bit.
+	const uint16_t WALL_PAIRS = COLUMNS | (COLUMNS >> 1);
+	
+	inline int popcount16(uint16_t x) {
+	#if defined(__GNUC__) && defined(__POPCNT__)
+		return __builtin_popcount(x);
+	#else
+		x = x - ((x >> 1) & 0x5555);
+		x = (x & 0x3333) + ((x >> 2) & 0x3333);
+		x = (x + (x >> 4)) & 0x0F0F;
+		return (x + (x >> 8)) & 0x1F;
+	#endif
+	}
+	
+	// Plain C++, one board at a time.
+	inline void scoreBatchScalar(const BoardBatch& batch, const EvalWeights& weights, float* scores) {
+		for (int lane = 0; lane < batch.count; lane++) {
+			int height = 0, holes = 0, bumpiness = 0, wells = 0;
+			int transitions = 2 * (Board::HEIGHT - 1 - batch.topRow);
+			
+			uint16_t seen = Board::EMPTY_ROW;
+			for (int y = batch.topRow; y >= 0; y--) {
+				uint16_t row = batch.rows[y][lane];
+				holes += popcount16(seen & ~row & COLUMNS);
+				seen |= row;
+				
+				height      += popcount16(seen & COLUMNS);
+				bumpiness   += popcount16((seen ^ (seen >> 1)) & COLUMN_PAIRS);
+				wells       += popcount16(~seen & (seen << 1) & (seen >> 1) & COLUMNS);
+				transitions += popcount16((row ^ (row >> 1)) & WALL_PAIRS);
+			}
+			
+			scores[lane] = weights.height         * height
+			             + weights.lines          * batch.linesCleared[lane]
+			             + weights.holes          * holes
+			             + weights.bumpiness      * bumpiness
+			             + weights.wells          * wells
+			             + weights.rowTransitions * transitions;
+		}
+	}
+
+#ifdef __AVX2__
+	// Popcount of each 16-bit lane: a nibble lookup table per byte
+	// (`vpshufb`), then adjacent bytes summed (`vpmaddubsw`).
+	inline __m256i popcount16x16(__m256i x) {
+		const __m256i table = _mm256_setr_epi8(
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+		);
+		const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+		
+		__m256i low  = _mm256_shuffle_epi8(table, _mm256_and_si256(x, lowNibbles));
+		__m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(x, 4), lowNibbles));
+		return _mm256_maddubs_epi16(_mm256_add_epi8(low, high), _mm256_set1_epi8(1));
+	}
+	
+	// Turns 16 lanes of 16-bit counts into two halves of 8 floats.
+	inline void toFloats(__m256i x, __m256& low, __m256& high) {
+		low  = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(x)));
+		high = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(x, 1)));
+	}
+	
+	// The same thing, all 16 boards at once.
+	inline void scoreBatchAvx2(const BoardBatch& batch, const EvalWeights& weights, float* scores) {
+		const __m256i columns     = _mm256_set1_epi16(COLUMNS);
+		const __m256i columnPairs = _mm256_set1_epi16(COLUMN_PAIRS);
+		const __m256i wallPairs   = _mm256_set1_epi16(WALL_PAIRS);
+		
+		__m256i height = _mm256_setzero_si256(), holes = height, bumpiness = height, wells = height;
+		__m256i transitions = _mm256_set1_epi16(2 * (Board::HEIGHT - 1 - batch.topRow));
+		
+		__m256i seen = _mm256_set1_epi16(Board::EMPTY_ROW);
+		for (int y = batch.topRow; y >= 0; y--) {
+			__m256i row = _mm256_load_si256((const __m256i*)batch.rows[y]);
+			holes = _mm256_add_epi16(holes, popcount16x16(_mm256_and_si256(_mm256_andnot_si256(row, seen), columns)));
+			seen = _mm256_or_si256(seen, row);
+			
+			height = _mm256_add_epi16(height, popcount16x16(_mm256_and_si256(seen, columns)));
+			
+			__m256i steps = _mm256_xor_si256(seen, _mm256_srli_epi16(seen, 1));
+			bumpiness = _mm256_add_epi16(bumpiness, popcount16x16(_mm256_and_si256(steps, columnPairs)));
+			
+			__m256i walled = _mm256_and_si256(_mm256_slli_epi16(seen, 1), _mm256_srli_epi16(seen, 1));
+			wells = _mm256_add_epi16(wells, popcount16x16(_mm256_and_si256(_mm256_andnot_si256(seen, walled), columns)));
+			
+			__m256i flips = _mm256_xor_si256(row, _mm256_srli_epi16(row, 1));
+			transitions = _mm256_add_epi16(transitions, popcount16x16(_mm256_and_si256(flips, wallPairs)));
+		}
+		
+		__m256 feature[5][2];
+		toFloats(height,      feature[0][0], feature[0][1]);
+		toFloats(holes,       feature[1][0], feature[1][1]);
+		toFloats(bumpiness,   feature[2][0], feature[2][1]);
+		toFloats(wells,       feature[3][0], feature[3][1]);
+		toFloats(transitions, feature[4][0], feature[4][1]);
+		
+		// Same order of operations as the scalar version, so both agree.
+		for (int half = 0; half < 2; half++) {
+			__m256 lines = _mm256_cvtepi32_ps(_mm256_load_si256((const __m256i*)&batch.linesCleared[half * 8]));
+			__m256 score = _mm256_mul_ps(_mm256_set1_ps(weights.height), feature[0][half]);
+			score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.lines), lines));
+			score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.holes), feature[1][half]));
+			score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.bumpiness), feature[2][half]));
+			score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.wells), feature[3][half]));
+			score = _mm256_add_ps(score, _mm256_mul_ps(_mm256_set1_ps(weights.rowTransitions), feature[4][half]));
+			_mm256_storeu_ps(scores + half * 8, score);
+		}
+	}
+#endif
+}
+
+// Scores the boards in a batch: `scores[i]` for each lane below `batch.count`.
+// (`scores` needs room for `BoardBatch::LANES` floats, though.)
+inline void scoreBatch(const BoardBatch& batch, const EvalWeights& weights, float* scores) {
+#ifdef __AVX2__
+	evaluate::scoreBatchAvx2(batch, weights, scores);
+#else
+	evaluate::scoreBatchScalar(batch, weights, scores);
+#endif
+}
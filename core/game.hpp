@@ -0,0 +1,295 @@
+// Guideline Tetris!!
+// All of the game's state and rules, with no window or clock attached.
+// Whoever owns a `Game` feeds it input and elapsed time, one step at a time.
+
+#pragma once
+
+#include "board.hpp"
+#include "piece.hpp"
+#include "piecebag.hpp"
+#include "pieces.hpp"
+#include "pieceset.hpp"
+#include "rng.hpp"
+#include "zobrist.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+// Everything the game needs to know about the player's input for one step.
+struct InputFrame {
+	// Key presses since the last step. (These don't repeat on their own.)
+	int dx = 0;            // tapped Left (-1) or Right (+1)
+	int rotate = 0;        // Z (-1) or X (+1)
+	bool hardDrop = false; // Up
+	bool restart = false;  // R
+	
+	// Keys that are currently held down.
+	bool leftHeld = false;
+	bool rightHeld = false;
+	bool softDropHeld = false; // Down
+	
+	// Forgets the key presses, but not what's held.
+	// (For when one frame of input gets spread over several steps.)
+	void clearTaps() {
+		dx = 0; rotate = 0;
+		hardDrop = false; restart = false;
+	}
+	
+	// Squishes the whole frame into 9 bits (for replays and such).
+	// Directions are stored as 2-bit signed numbers.
+	uint16_t pack() const {
+		return (dx & 3)
+		     | (rotate & 3) << 2
+		     | hardDrop     << 4
+		     | restart      << 5
+		     | leftHeld     << 6
+		     | rightHeld    << 7
+		     | softDropHeld << 8;
+	}
+	
+	static InputFrame unpack(uint16_t bits) {
+		// Sign-extends a 2-bit number.
+		auto direction = [](int twoBits) { return (twoBits & 2) ? twoBits - 4 : twoBits; };
+		
+		InputFrame input;
+		input.dx           = direction(bits & 3);
+		input.rotate       = direction(bits >> 2 & 3);
+		input.hardDrop     = bits >> 4 & 1;
+		input.restart      = bits >> 5 & 1;
+		input.leftHeld     = bits >> 6 & 1;
+		input.rightHeld    = bits >> 7 & 1;
+		input.softDropHeld = bits >> 8 & 1;
+		return input;
+	}
+};
+
+struct Game {
+	// Extremely basic Delayed Auto Shift (DAS)
+	static constexpr float MOVE_DELAY_INITIAL = 0.175;
+	static constexpr float MOVE_DELAY = 0.0625;
+	
+	// How many garbage lines clearing 0, 1, 2... lines at once sends.
+	// (Only matters in versus mode.)
+	static constexpr int GARBAGE_SENT[] = { 0, 0, 1, 2, 4, 6 };
+	
+	Board board;
+	Piece piece;
+	PieceBag bag;
+	
+	// Which pieces there are. (Has to outlive the game.)
+	const PieceSet* pieceSet;
+	
+	// Fall Speed timers.
+	float timer = 0;
+	
+	float moveTimer = 0;
+	bool moveRepeated = false; // have we moved once yet?
+	bool piecePlaced = false;
+	
+	bool gameOver = true; // ssshhh! the title screen is just if the game over screen said something else
+	
+	long int score = 0, highScore = 13370;
+	int lines = 0;
+	int levelNum = 0;
+	
+	// How many pieces have been placed this game.
+	long int pieces = 0;
+	
+	// The lines cleared on the last step, if any. (For effects and such.)
+	LineClear lastClear;
+	
+	// Info about the current level. (Kept around for drawing.)
+	Level level;
+	
+	// Versus mode: garbage lines on their way in, which come up the next
+	// time a piece lands without clearing anything, and lines this game has
+	// sent that haven't been picked up yet. (See versus.hpp.)
+	int garbageQueued = 0;
+	int garbageToSend = 0;
+	
+	// Where the holes in garbage go. (Its own RNG, so it doesn't change
+	// which pieces come.)
+	Rng garbageRng;
+	
+	Game(uint64_t seed = 1, const PieceSet& set = BUILT_IN_PIECE_SET)
+		: bag(seed, getLevel(0, set).piecesRange), pieceSet(&set), level(getLevel(0, set)), garbageRng(~seed) {
+		piece.reset(bag.getNext(), set);
+	}
+	
+	// Starts a new game. The high score sticks around.
+	void restart() {
+		gameOver = false;
+		
+		board.clear();
+		bag.reset(getLevel(0, *pieceSet).piecesRange);
+		piece.reset(bag.getNext(), *pieceSet);
+		
+		score = 0; lines = 0; pieces = 0;
+		lastClear = LineClear();
+		garbageQueued = 0; garbageToSend = 0;
+		
+		moveRepeated = false;
+		moveTimer = 0; timer = 0;
+	}
+	
+	// Advances the game by `dt` seconds.
+	void step(const InputFrame& input, float dt) {
+		if (input.restart) restart();
+		
+		// Taps only count if we're not already auto-shifting.
+		int dx = 0;
+		if (input.dx != 0 && !moveRepeated && moveTimer == 0)
+			dx = input.dx;
+		
+		levelNum = lines / 6; // extremely simple level system
+		level = getLevel(levelNum, *pieceSet);
+		levelNum++; // oops! i multiply by this number!
+		
+		// Timer logic
+		if (!input.leftHeld && !input.rightHeld) {
+			// Reset timer if no directions are being held.
+			moveTimer = 0;
+			moveRepeated = false;
+		} else {
+			// Increment timer by delta time.
+			moveTimer += dt;
+		}
+		
+		// Respond to held keys.
+		// (There's a different delay based on if it's the first repetition or
+		//  if it's any beyond; `moveRepeated` keeps track of that.)
+		if ((!moveRepeated && moveTimer > MOVE_DELAY_INITIAL)
+		||  ( moveRepeated && moveTimer > MOVE_DELAY)) {
+			if (input.leftHeld)  dx = -1;
+			if (input.rightHeld) dx = +1;
+			moveTimer = 0;
+			moveRepeated = true;
+		}
+		
+		// This doesn't have key repeat.
+		float fallDelay = level.fallDelay;
+		if (input.softDropHeld) fallDelay /= 6.0;
+		
+		bag.setPiecesRange(level.piecesRange.first, level.piecesRange.second);
+		
+		if (gameOver) return;
+		
+		// Move piece
+		if (dx != 0) {
+			if (piece.fits(board, { dx, 0 })) {
+				// janky, but resets the timer if piece
+				// is either moved off of or onto a surface
+				// (to make lockDelay easier to implement)
+				if (!piece.fits(board, { 0, -1 }))
+					timer = 0;
+				piece.position.x += dx;
+				if (!piece.fits(board, { 0, -1 }))
+					timer = 0;
+			}
+		}
+		
+		// Drop piece all the way to the bottom
+		if (input.hardDrop) {
+			piece.position.y = piece.getDropYCoord(board);
+			piecePlaced = true;
+			timer = 0;
+		}
+		
+		// Rotate piece
+		if (input.rotate != 0)
+			piece.rotate(board, input.rotate);
+		
+		// Fall one tile per tick
+		timer += dt;
+		if (piece.fits(board, { 0, -1 })) {
+			if (timer > fallDelay) {
+				piece.position.y -= 1;
+				timer = 0;
+			}
+		} else {
+			if (timer > level.lockDelay) {
+				piecePlaced = true;
+				timer = 0;
+			}
+		}
+		
+		// If piece was hard dropped or it locked,..
+		lastClear = LineClear();
+		int placedY = -1;
+		if (piecePlaced) {
+			// ...write it to the board.
+			piece.place(board);
+			placedY = piece.position.y;
+			
+			// and give out the points for placing a piece.
+			score += levelNum;
+			pieces++;
+			
+			// After that, spawn a new piece.
+			piece.reset(bag.getNext(), *pieceSet);
+			piecePlaced = false;
+			
+			// Bump up if not fitting on board
+			if (!piece.fits(board)) {
+				piece.position.y++;
+				// *Then* game over if it still doesn't fit.
+				if (!piece.fits(board))
+					gameOver = true;
+			}
+		}
+		
+		// Check for and remove filled lines
+		// (only new tiles can fill one, so just where the piece landed)
+		if (placedY >= 0)
+			lastClear = board.clearLines(placedY - PIECE_REACH, placedY + PIECE_REACH);
+		if (lastClear.count) {
+			lines += lastClear.count;
+			score += lastClear.count * 50 * levelNum;
+			
+			// Clearing lines cancels out garbage on its way in first, and
+			// whatever's left over gets sent.
+			int sent = GARBAGE_SENT[std::min<int>(lastClear.count, std::size(GARBAGE_SENT) - 1)];
+			int cancelled = std::min(sent, garbageQueued);
+			garbageQueued -= cancelled;
+			garbageToSend += sent - cancelled;
+		} else if (placedY >= 0 && garbageQueued > 0) {
+			raiseGarbage();
+		}
+		
+		// Update high score if you've exceeded it.
+		if (score > highScore)
+			highScore = score;
+	}
+	
+	// Brings up all of the queued garbage, with the hole in one column.
+	// The new piece has already spawned, so it gets pushed up out of the way
+	// (and if it can't be, that's game over).
+	void raiseGarbage() {
+		int count = garbageQueued;
+		garbageQueued = 0;
+		
+		bool toppedOut = board.addGarbage(count, garbageRng.below(Board::WIDTH), GARBAGE_TILE);
+		for (int i = 0; i < count && !piece.fits(board); i++)
+			piece.position.y++;
+		
+		if (toppedOut || !piece.fits(board))
+			gameOver = true;
+	}
+	
+	// Zobrist hash of the position: which tiles are filled, the falling
+	// piece and the visible queue. (Not where the piece is, or the timers.)
+	uint64_t getHash() const {
+		uint64_t hash = board.hash ^ zobrist::piece(0, piece.id);
+		for (int i = 0; i < PieceBag::MIN_VISIBLE; i++)
+			hash ^= zobrist::piece(1 + i, bag.peek(i));
+		return hash;
+	}
+};
+
+// A whole game is one flat struct, so a plain copy of one is a complete
+// snapshot of it, for rolling back and such (see rollback.hpp). Keep it that
+// way: no containers or owning pointers in here. (`pieceSet` and the
+// piece's shape just point at the set, which outlives every game.)
+static_assert(std::is_trivially_copyable<Game>::value, "games have to be copyable with memcpy");
@@ -0,0 +1,182 @@
+// Guideline Tetris!!
+// Looks a few pieces ahead: the best spot for the falling piece, given
+// where the pieces after it could go.
+
+#pragma once
+
+#include "board.hpp"
+#include "evaluate.hpp"
+#include "movegen.hpp"
+#include "piece.hpp"
+#include "pieceset.hpp"
+#include "transposition.hpp"
+#include "zobrist.hpp"
+
+#include <memory>
+
+// Tries every placement (from MoveGenerator) of the falling piece, then
+// every placement of the next piece on each of the boards that leaves, and
+// so on through the known pieces, then scores the boards at the bottom a
+// batch at a time (see evaluate.hpp). A placement's worth is the best that
+// can be done after it: the lines cleared all the way down, plus the last
+// board's score.
+//
+// The same boards, with the same pieces still to come, keep turning up
+// (through different placements, across searches, and across threads), so
+// every position's worth goes in a TranspositionTable, keyed by its board's
+// Zobrist hash and the pieces left. Give each thread its own search, and
+// they can all share one table.
+//
+// Each search owns a move generator per level (they're big), so keep one
+// around and reuse it; `search` never allocates.
+struct LookaheadSearch {
+	// How many pieces deep it can go, counting the falling one.
+	static const int MAX_DEPTH = 8;
+	static_assert(MAX_DEPTH <= zobrist::QUEUE_SLOTS, "not enough zobrist keys for the queue");
+	
+	// What a position's worth if the next piece doesn't even fit.
+	static constexpr float TOPPED_OUT = -1e9f;
+	
+	// How the boards at the bottom get scored.
+	EvalWeights weights = NEAR_PERFECT_WEIGHTS;
+	
+	// Shared with whoever else is searching, or none.
+	TranspositionTable* table = nullptr;
+	
+	// Counts, since this was made (for seeing how well the table's doing).
+	long int nodes = 0;  // positions searched (or found in the table)
+	long int hits = 0;   // found in the table
+	
+	// Which placement won, and what it was worth.
+	struct Result {
+		bool found = false;
+		MoveGenerator::Placement placement = {};
+		float score = TOPPED_OUT;
+	};
+	
+	LookaheadSearch(TranspositionTable* table = nullptr) : table(table), generators(new MoveGenerator[MAX_DEPTH]) {}
+	
+	// Finds the best placement for `piece` (from wherever it is now), given
+	// that `next[0]`, `next[1]`... come after it. Looks `depth` pieces deep
+	// in all, at most (and no further than the pieces it knows about).
+	// The path there is in `getPath` afterwards.
+	Result search(const Board& board, const Piece& piece, const int* next, int nextCount, int depth,
+		const PieceSet& set = BUILT_IN_PIECE_SET) {
+		this->set = &set;
+		if (depth > MAX_DEPTH) depth = MAX_DEPTH;
+		if (depth > nextCount + 1) depth = nextCount + 1;
+		
+		Result result;
+		if (depth < 1) return result;
+		for (int i = 0; i < depth - 1; i++)
+			pieces[i + 1] = next[i];
+		
+		MoveGenerator& generator = generators[0];
+		int count = generator.generate(board, piece);
+		
+		BoardBatch batch;
+		int lanes[BoardBatch::LANES];
+		float scores[BoardBatch::LANES];
+		auto scoreLeaves = [&]() {
+			scoreBatch(batch, weights, scores);
+			for (int i = 0; i < batch.count; i++)
+				consider(result, lanes[i], scores[i]);
+			batch.clear();
+		};
+		
+		for (int i = 0; i < count; i++) {
+			Board scratch = board;
+			int cleared = placeAndClear(scratch, piece, generator.placements[i]);
+			
+			if (depth == 1) {
+				lanes[batch.add(scratch, cleared)] = i;
+				if (batch.isFull()) scoreLeaves();
+			} else {
+				consider(result, i, weights.lines * cleared + evaluate(scratch, 1, depth - 1));
+			}
+		}
+		if (batch.count > 0) scoreLeaves();
+		
+		return result;
+	}
+	
+	// The moves to get the falling piece to the last search's result.
+	int getPath(const Result& result, MoveGenerator::PathStep* steps, int maxSteps) const {
+		return generators[0].getPath(result.placement, steps, maxSteps);
+	}
+
+private:
+	std::unique_ptr<MoveGenerator[]> generators;
+	const PieceSet* set = &BUILT_IN_PIECE_SET;
+	
+	// The pieces being searched: [0] is the falling one.
+	int pieces[MAX_DEPTH];
+	
+	void consider(Result& result, int placement, float score) {
+		if (result.found && score <= result.score) return;
+		result.found = true;
+		result.placement = generators[0].placements[placement];
+		result.score = score;
+	}
+	
+	// Drops the piece into a placement, and clears whatever lines that fills.
+	static int placeAndClear(Board& board, const Piece& piece, const MoveGenerator::Placement& placement) {
+		Piece placed = piece;
+		placed.position = placement.position;
+		placed.rotation = placement.rotation;
+		placed.place(board);
+		return board.clearLines(placement.position.y - PIECE_REACH, placement.position.y + PIECE_REACH).count;
+	}
+	
+	// The best that can be done from `board`, with `pieces[level]` on
+	// spawning, and `remaining` pieces (that one included) left to place.
+	float evaluate(const Board& board, int level, int remaining) {
+		nodes++;
+		
+		// The key covers just the pieces this search will place from here,
+		// in order, so the same board with the same pieces coming matches,
+		// whatever came before.
+		uint64_t key = board.hash;
+		for (int i = 0; i < remaining; i++)
+			key ^= zobrist::piece(i, pieces[level + i]);
+		
+		TranspositionTable::Result cached;
+		if (table && table->probe(key, cached) && cached.depth >= remaining) {
+			hits++;
+			return cached.score;
+		}
+		
+		Piece piece(pieces[level], *set);
+		MoveGenerator& generator = generators[level];
+		int count = generator.generate(board, piece);
+		
+		float best = TOPPED_OUT;
+		if (remaining == 1) {
+			BoardBatch batch;
+			float scores[BoardBatch::LANES];
+			auto scoreLeaves = [&]() {
+				scoreBatch(batch, weights, scores);
+				for (int i = 0; i < batch.count; i++)
+					if (scores[i] > best) best = scores[i];
+				batch.clear();
+			};
+			
+			for (int i = 0; i < count; i++) {
+				Board scratch = board;
+				batch.add(scratch, placeAndClear(scratch, piece, generator.placements[i]));
+				if (batch.isFull()) scoreLeaves();
+			}
+			if (batch.count > 0) scoreLeaves();
+		} else {
+			for (int i = 0; i < count; i++) {
+				Board scratch = board;
+				int cleared = placeAndClear(scratch, piece, generator.placements[i]);
+				float score = weights.lines * cleared + evaluate(scratch, level + 1, remaining - 1);
+				if (score > best) best = score;
+			}
+		}
+		
+		if (table) table->store(key, { best, remaining });
+		return best;
+	}
+};
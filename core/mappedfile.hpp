@@ -0,0 +1,88 @@
+// Guideline Tetris!!
+// Read-only memory-mapped files, for chewing through big files quickly.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// The whole file shows up at `data`, and the OS pages it in as it's read.
+struct MappedFile {
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	
+	MappedFile() {}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { close(); }
+	
+	bool open(const char* path) {
+		close();
+		
+	#ifdef _WIN32
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+		
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { close(); return false; }
+		size = fileSize.QuadPart;
+		
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping) { close(); return false; }
+		
+		data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!data) { close(); return false; }
+	#else
+		fd = ::open(path, O_RDONLY);
+		if (fd < 0) return false;
+		
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0) { close(); return false; }
+		size = info.st_size;
+		
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) { close(); return false; }
+		data = (const uint8_t*)mapped;
+		
+		// We're going to read it front to back.
+		madvise(mapped, size, MADV_SEQUENTIAL);
+	#endif
+		
+		return true;
+	}
+	
+	void close() {
+	#ifdef _WIN32
+		if (data) UnmapViewOfFile(data);
+		if (mapping) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+	#else
+		if (data) munmap((void*)data, size);
+		if (fd >= 0) ::close(fd);
+		fd = -1;
+	#endif
+		data = nullptr;
+		size = 0;
+	}
+	
+private:
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
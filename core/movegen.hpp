@@ -0,0 +1,205 @@
+// Guideline Tetris!!
+// Finds every spot a piece could end up locking in, tucks and spins included.
+
+#pragma once
+
+#include "board.hpp"
+#include "piece.hpp"
+#include "piecetables.hpp"
+#include "vec.hpp"
+
+#include <cstdint>
+
+// A breadth-first search over every (x, y, rotation) the piece can get to
+// with left, right, both rotations (kicks and all, exactly like
+// `Piece::rotate`) and soft drop. Gravity and timing are ignored: anything
+// you could get to with fast enough fingers counts.
+//
+// Everything lives inside the generator, so keep one around and reuse it;
+// `generate` never allocates.
+struct MoveGenerator {
+	enum Move : uint8_t {
+		LEFT,
+		RIGHT,
+		ROTATE_CW,
+		ROTATE_CCW,
+		SOFT_DROP, // may fall several rows at once, through open space
+	};
+	
+	static const int STATE_COUNT = 4 * Board::HEIGHT * Board::WIDTH;
+	
+	// A spot the piece would lock in (it can't go any further down there).
+	struct Placement {
+		Vec2i position;
+		int rotation;
+		
+		// Where the search found it, for `getPath`.
+		int16_t state;
+	};
+	
+	// One move along a path, and where the piece ends up after it.
+	struct PathStep {
+		Move move;
+		Vec2i position;
+		int rotation;
+	};
+	
+	// The results of the last `generate`. Placements covering exactly the
+	// same tiles (like an O piece in all four rotations) only show up once,
+	// as whichever was quickest to get to.
+	Placement placements[STATE_COUNT];
+	int placementCount = 0;
+	
+	// Finds every placement reachable from where `piece` is now.
+	// Returns how many there are (0 if the piece doesn't even fit).
+	int generate(const Board& board, const Piece& piece) {
+		placementCount = 0;
+		this->piece = piece;
+		if (!piece.fits(board)) return 0;
+		
+		for (int r = 0; r < 4; r++)
+			for (int y = 0; y < Board::HEIGHT; y++)
+				visited[r][y] = 0;
+		
+		if (++generation == 0) {
+			for (auto& stamp : stamps) stamp = 0;
+			generation = 1;
+		}
+		
+		// Everywhere at or above `openY`, the piece and any kick it takes
+		// only ever touch empty rows, so the only thing to bump into is the
+		// walls. Up there, height doesn't matter, and soft drops can skip
+		// straight down to `openY`.
+		openY = board.getMaxHeight() + PIECE_REACH + piece.shape->maxKickDrop;
+		
+		queueLength = 0;
+		visit(piece.position, piece.rotation, -1, SOFT_DROP);
+		
+		for (int next = 0; next < queueLength; next++) {
+			int state = queue[next];
+			int r = state / (Board::HEIGHT * Board::WIDTH);
+			Vec2i position = { state % Board::WIDTH, state / Board::WIDTH % Board::HEIGHT };
+			
+			if (fits(board, position + Vec2i{ -1, 0 }, r))
+				visit(position + Vec2i{ -1, 0 }, r, state, LEFT);
+			if (fits(board, position + Vec2i{ +1, 0 }, r))
+				visit(position + Vec2i{ +1, 0 }, r, state, RIGHT);
+			
+			tryRotate(board, position, r, +1, state, ROTATE_CW);
+			tryRotate(board, position, r, -1, state, ROTATE_CCW);
+			
+			Vec2i below = { position.x, position.y > openY ? openY : position.y - 1 };
+			if (fits(board, below, r))
+				visit(below, r, state, SOFT_DROP);
+			else
+				addPlacement(position, r, state);
+		}
+		
+		return placementCount;
+	}
+	
+	// Writes the moves that get from the starting spot to a placement.
+	// Returns how many there are (which might be more than `maxSteps`,
+	// in which case only the first `maxSteps` get written).
+	int getPath(const Placement& placement, PathStep* steps, int maxSteps) const {
+		int count = 0;
+		for (int s = placement.state; parents[s] >= 0; s = parents[s]) count++;
+		
+		int i = count;
+		for (int s = placement.state; parents[s] >= 0; s = parents[s]) {
+			if (--i >= maxSteps) continue;
+			steps[i].move = parentMoves[s];
+			steps[i].position = { s % Board::WIDTH, s / Board::WIDTH % Board::HEIGHT };
+			steps[i].rotation = s / (Board::HEIGHT * Board::WIDTH);
+		}
+		return count;
+	}
+
+private:
+	// Dedupes placements by the tiles they cover.
+	static const int TABLE_SIZE = 4096;
+	static_assert(TABLE_SIZE >= STATE_COUNT * 2, "placement table would get too full");
+	
+	Piece piece;
+	int openY = 0;
+	
+	// Which states have been seen: bit x of `visited[rotation][y]`.
+	uint16_t visited[4][Board::HEIGHT];
+	static_assert(Board::WIDTH <= 16, "visited rows are 16 bits wide");
+	
+	int16_t queue[STATE_COUNT];
+	int queueLength = 0;
+	
+	// How each state was first reached.
+	int16_t parents[STATE_COUNT];
+	Move parentMoves[STATE_COUNT];
+	
+	uint64_t keys[TABLE_SIZE];
+	uint32_t stamps[TABLE_SIZE] = { 0 };
+	uint32_t generation = 0;
+	
+	static int getState(Vec2i position, int rotation) {
+		return (rotation * Board::HEIGHT + position.y) * Board::WIDTH + position.x;
+	}
+	
+	bool fits(const Board& board, Vec2i position, int rotation) const {
+		return piece.fitsAbs(board, position, rotation);
+	}
+	
+	void visit(Vec2i position, int rotation, int parent, Move move) {
+		uint16_t bit = 1 << position.x;
+		if (visited[rotation][position.y] & bit) return;
+		visited[rotation][position.y] |= bit;
+		
+		int state = getState(position, rotation);
+		parents[state] = parent;
+		parentMoves[state] = move;
+		queue[queueLength++] = state;
+	}
+	
+	// Same as `Piece::rotate`: the first kick that fits wins.
+	void tryRotate(const Board& board, Vec2i position, int rotation, int direction, int state, Move move) {
+		int nextRotation = (rotation + direction) & 3;
+		const Vec2i* kicks = piece.shape->kicks[rotation][nextRotation];
+		for (int i = 0; i < piece.shape->kickCount; i++) {
+			if (fits(board, position + kicks[i], nextRotation)) {
+				visit(position + kicks[i], nextRotation, state, move);
+				return;
+			}
+		}
+	}
+	
+	// The tiles a placement covers, squished into 64 bits: the lowest row
+	// the piece touches, then each row's columns from there on up.
+	uint64_t getTileKey(Vec2i position, int rotation) const {
+		const uint16_t* rowMasks = piece.shape->rowMasks[rotation];
+		int shift = position.x + Board::WALL_BITS - PIECE_REACH;
+		
+		uint64_t key = 0;
+		int base = -1;
+		for (int i = 0; i < PieceShape::MASK_ROWS; i++) {
+			uint64_t columns = (uint16_t)(rowMasks[i] << shift) >> Board::WALL_BITS;
+			if (base < 0) {
+				if (!columns) continue;
+				base = i;
+				key = position.y + i - PIECE_REACH;
+			}
+			key |= columns << (6 + (i - base) * Board::WIDTH);
+		}
+		return key;
+	}
+	
+	void addPlacement(Vec2i position, int rotation, int state) {
+		uint64_t key = getTileKey(position, rotation);
+		
+		int slot = (key * 0x9E3779B97F4A7C15) >> 52;
+		while (stamps[slot] == generation) {
+			if (keys[slot] == key) return;
+			slot = (slot + 1) & (TABLE_SIZE - 1);
+		}
+		stamps[slot] = generation;
+		keys[slot] = key;
+		
+		placements[placementCount++] = { position, rotation, (int16_t)state };
+	}
+};
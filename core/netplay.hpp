@@ -0,0 +1,250 @@
+// Guideline Tetris!!
+// Two-player versus over UDP: the packets, and a link that sends them
+// (through a fake bad network, if asked).
+
+#pragma once
+
+#include "rng.hpp"
+#include "rollback.hpp"
+#include "udp.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+// Packets are tiny and get sent every tick. Everything's little-endian.
+//
+//   u16  MAGIC
+//   u8   type
+//
+//   HELLO (until both sides have heard from each other)
+//     u8   which player the sender is
+//     u64  seed (only player 0's counts)
+//
+//   INPUTS (every tick after that)
+//     u32  the sender's frame
+//     i8   how far ahead of us the sender thinks it is
+//     u32  how many of our inputs the sender has
+//     u32  which frame the inputs start at
+//     u8   how many inputs
+//     u16  inputs...   (packed InputFrames)
+//
+// Every INPUTS packet carries every input the other side hasn't said it's
+// got yet, so a lost packet just means the next one has a bit more in it.
+namespace netplay {
+	const uint16_t MAGIC = 0x544E; // "NT"
+	const uint8_t HELLO = 1;
+	const uint8_t INPUTS = 2;
+	
+	const int MAX_INPUTS = RollbackSession::HISTORY;
+	const int MAX_PACKET = 3 + 4 + 1 + 4 + 4 + 1 + MAX_INPUTS * 2;
+	
+	// Writes and reads little-endian numbers, without reading past the end.
+	struct Cursor {
+		uint8_t* data;
+		int size;
+		int used = 0;
+		bool ok = true;
+		
+		void put(uint64_t value, int bytes) {
+			for (int i = 0; i < bytes; i++) data[used++] = value >> (i * 8);
+		}
+		
+		uint64_t get(int bytes) {
+			if (used + bytes > size) {
+				ok = false;
+				return 0;
+			}
+			uint64_t value = 0;
+			for (int i = 0; i < bytes; i++) value |= (uint64_t)data[used++] << (i * 8);
+			return value;
+		}
+	};
+}
+
+// Pretends to be a bad network: drops some packets, and holds the rest back
+// for a while (a different while for each, so they can arrive out of
+// order). Time is whatever the caller says it is, in seconds.
+struct LossyLink {
+	static const int CAPACITY = 256;
+	
+	float lossRate = 0;  // 0 to 1
+	double latency = 0;  // one way, in seconds
+	double jitter = 0;   // up to this much more, at random
+	
+	Rng rng;
+	
+	bool isActive() const { return lossRate > 0 || latency > 0 || jitter > 0; }
+	
+	// Sends it later, or never. (If the queue's full, it's lost too.)
+	void send(UdpSocket& socket, const UdpAddress& to, const uint8_t* data, int size, double now) {
+		if (rng.below(1000000) < lossRate * 1000000) return;
+		if (count == CAPACITY) return;
+		
+		Delayed& packet = queue[count++];
+		packet.due = now + latency + jitter * rng.below(1001) / 1000.0;
+		packet.to = to;
+		packet.size = size;
+		memcpy(packet.data, data, size);
+		flush(socket, now);
+	}
+	
+	// Sends whatever's due by now.
+	void flush(UdpSocket& socket, double now) {
+		for (int i = 0; i < count; ) {
+			if (queue[i].due > now) {
+				i++;
+				continue;
+			}
+			socket.send(queue[i].to, queue[i].data, queue[i].size);
+			queue[i] = queue[--count];
+		}
+	}
+
+private:
+	struct Delayed {
+		double due;
+		UdpAddress to;
+		int size;
+		uint8_t data[netplay::MAX_PACKET];
+	};
+	Delayed queue[CAPACITY];
+	int count = 0;
+};
+
+// One side of a two-player game: says hello until the other side answers,
+// then swaps inputs with it every tick.
+struct NetplayLink {
+	// With nothing heard for this long, the other side's gone.
+	static constexpr double TIMEOUT = 5.0;
+	
+	UdpSocket socket;
+	
+	// Who's on the other end. Player 0 can leave this blank (port 0), to
+	// take whoever says hello first.
+	UdpAddress peer;
+	
+	int player = 0;    // 0 picks the seed, 1 goes along with it
+	uint64_t seed = 0;
+	bool connected = false;
+	double lastHeard = 0;
+	
+	// Set this up to test on a bad network without having one.
+	LossyLink shim;
+	
+	bool open(int localPort, const UdpAddress& peer, int player, uint64_t seed) {
+		this->peer = peer;
+		this->player = player;
+		this->seed = seed;
+		connected = false;
+		return socket.open(localPort);
+	}
+	
+	// While connecting: says hello, and listens for one back.
+	// Returns true once there's somebody there (and `seed` is agreed on).
+	bool connect(double now) {
+		uint8_t packet[netplay::MAX_PACKET];
+		UdpAddress from;
+		int size;
+		while ((size = socket.receive(packet, sizeof(packet), from)) >= 0) {
+			if (from != peer && peer.port != 0) continue;
+			netplay::Cursor in = { packet, size };
+			if (in.get(2) != netplay::MAGIC) continue;
+			
+			// Either a hello, or (if ours got through, and theirs since got
+			// lost) the game's already started over there.
+			uint8_t type = in.get(1);
+			if (type == netplay::HELLO) {
+				int theirPlayer = in.get(1);
+				uint64_t theirSeed = in.get(8);
+				if (!in.ok || theirPlayer == player) continue;
+				if (player == 1) seed = theirSeed;
+				peer = from;
+				connected = true;
+			} else if (type == netplay::INPUTS && player == 0 && peer.port != 0) {
+				connected = true;
+			}
+		}
+		
+		if (peer.port != 0) sendHello(now);
+		if (connected) lastHeard = now;
+		return connected;
+	}
+	
+	// Sends this side's unacknowledged inputs, and where it's at.
+	void sendInputs(const RollbackSession& session, double now) {
+		uint32_t first = session.localAcked;
+		int count = session.frame - first;
+		if (count > netplay::MAX_INPUTS) count = netplay::MAX_INPUTS;
+		
+		int advantage = session.getLocalAdvantage();
+		if (advantage < -128) advantage = -128;
+		if (advantage > 127) advantage = 127;
+		
+		uint8_t packet[netplay::MAX_PACKET];
+		netplay::Cursor out = { packet, sizeof(packet) };
+		out.put(netplay::MAGIC, 2);
+		out.put(netplay::INPUTS, 1);
+		out.put(session.frame, 4);
+		out.put((uint8_t)advantage, 1);
+		out.put(session.remoteConfirmed, 4);
+		out.put(first, 4);
+		out.put(count, 1);
+		for (int i = 0; i < count; i++)
+			out.put(session.getLocalInput(first + i), 2);
+		send(packet, out.used, now);
+	}
+	
+	// Hands everything that's arrived to the session. Returns false if the
+	// other side seems to be gone.
+	bool receiveInputs(RollbackSession& session, double now) {
+		if (shim.isActive()) shim.flush(socket, now);
+		
+		uint8_t packet[netplay::MAX_PACKET];
+		UdpAddress from;
+		int size;
+		while ((size = socket.receive(packet, sizeof(packet), from)) >= 0) {
+			if (from != peer) continue;
+			netplay::Cursor in = { packet, size };
+			if (in.get(2) != netplay::MAGIC) continue;
+			
+			// Still saying hello means they haven't heard ours (it's only
+			// sent back, so it could have been lost).
+			uint8_t type = in.get(1);
+			if (type == netplay::HELLO) sendHello(now);
+			if (type != netplay::INPUTS) continue;
+			
+			uint32_t theirFrame = in.get(4);
+			int theirAdvantage = (int8_t)in.get(1);
+			uint32_t theirConfirmed = in.get(4);
+			uint32_t first = in.get(4);
+			int count = in.get(1);
+			
+			uint16_t inputs[netplay::MAX_INPUTS];
+			if (count > netplay::MAX_INPUTS) continue;
+			for (int i = 0; i < count; i++) inputs[i] = in.get(2);
+			if (!in.ok) continue;
+			
+			session.receiveStatus(theirFrame, theirAdvantage, theirConfirmed);
+			session.receiveInputs(first, inputs, count);
+			lastHeard = now;
+		}
+		
+		return now - lastHeard < TIMEOUT;
+	}
+
+private:
+	void sendHello(double now) {
+		uint8_t packet[netplay::MAX_PACKET];
+		netplay::Cursor out = { packet, sizeof(packet) };
+		out.put(netplay::MAGIC, 2);
+		out.put(netplay::HELLO, 1);
+		out.put(player, 1);
+		out.put(seed, 8);
+		send(packet, out.used, now);
+	}
+	
+	void send(const uint8_t* data, int size, double now) {
+		if (shim.isActive()) shim.send(socket, peer, data, size, now);
+		else socket.send(peer, data, size);
+	}
+};
@@ -0,0 +1,141 @@
+// Guideline Tetris!!
+// The piece that's currently falling.
+
+#pragma once
+
+#include "board.hpp"
+#include "pieces.hpp"
+#include "pieceset.hpp"
+#include "piecetables.hpp"
+#include "vec.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+struct Piece {
+	// Each piece has a reference to its precomputed shape,
+	// to retrieve tiles, tile color and rotation nudge tables.
+	const PieceShape* shape;
+	
+	// Which piece of its set it is.
+	int id = 0;
+	
+	// The position of the piece on the board.
+	Vec2i position;
+	
+	// The rotation the piece is at.
+	int rotation = 0;
+	
+	// The piece's initial position on the board.
+	static constexpr std::pair<int, int> INITIAL_POSITION = { 4, 20 };
+	
+	Piece(int id = 0, const PieceSet& set = BUILT_IN_PIECE_SET) { reset(id, set); }
+	
+	// I'm lazy. This is basically the constructor again.
+	void reset(int id = 0, const PieceSet& set = BUILT_IN_PIECE_SET) {
+		shape = &set.getShape(id);
+		this->id = id;
+		position = { INITIAL_POSITION.first, INITIAL_POSITION.second };
+		rotation = 0;
+	}
+	
+	// The tiles making up the piece, relative to its position.
+	PieceShape::TileList getTiles() const {
+		return shape->getTiles(rotation);
+	}
+	
+	// Attempts to rotate the piece by the specified amount.
+	// Returns true if rotation succeeded.
+	bool rotate(const Board& board, int direction) {
+		int nextRotation = (rotation + direction) & 3;
+		
+		// The core of SRS:
+		const Vec2i* kicks = shape->kicks[rotation][nextRotation];
+		for (int i = 0; i < shape->kickCount; i++) {
+			// Nudge piece in the offset direction.
+			if (fitsAbs(board, position + kicks[i], nextRotation)) {
+				// If it fits, keep this new position
+				// and stop doing further checks.
+				position += kicks[i];
+				rotation = nextRotation;
+				return true;
+			}
+		}
+		// If you get past here, all checks failed,
+		// so the piece just stays as it was.
+		
+		return false;
+	}
+	
+	// Check if a piece fits on the board, not overlapping any non-zero tile.
+	// Optionally accepts an offset to the piece, a direction to bump its
+	// current position in.
+	bool fits(const Board& board, const Vec2i offset = { 0, 0 }) const {
+		return fitsAbs(board, position + offset, rotation);
+	}
+	
+	// Check if a piece fits on the board, not overlapping any non-zero tile.
+	// This does not use the piece's position.
+	bool fitsAbs(const Board& board, const Vec2i absPosition) const {
+		return fitsAbs(board, absPosition, rotation);
+	}
+	
+	// Same as above, but as if the piece were in some other rotation.
+	bool fitsAbs(const Board& board, const Vec2i absPosition, int atRotation) const {
+		// Every piece has tiles on both sides of (or in line with) its center,
+		// on both axes (PieceSet::load makes sure of it for loaded ones). So
+		// if the center is off the board, so is some tile.
+		// This also keeps the shifts below within the 16-bit rows.
+		if (!board.isOnBoard(absPosition)) return false;
+		
+		const uint16_t* rowMasks = shape->rowMasks[atRotation];
+		int shift = absPosition.x + Board::WALL_BITS - PIECE_REACH;
+		for (int i = 0; i < PieceShape::MASK_ROWS; i++) {
+			uint16_t row = rowMasks[i] << shift;
+			if (row & board.getRowMask(absPosition.y + i - PIECE_REACH))
+				return false;
+		}
+		return true;
+	}
+	
+	// Returns the lowest Y coordinate this piece can fall to,
+	// in its current position. Used for hard drops (and the ghost piece).
+	int getDropYCoord(const Board& board) const {
+		// Almost always, the piece is above everything under it. Then it
+		// just lands wherever the bottom of one of its columns first meets
+		// the top of that column on the board.
+		const int8_t* bottoms = shape->bottoms[rotation];
+		int dropY = 0;
+		for (int i = 0; i < PieceShape::COLUMNS; i++) {
+			if (bottoms[i] == PieceShape::NO_TILE) continue;
+			
+			int surface = board.getColumnHeight(position.x + i - PIECE_REACH);
+			if (position.y + bottoms[i] < surface)
+				return searchDropYCoord(board); // tucked under something
+			dropY = std::max(dropY, surface - bottoms[i]);
+		}
+		return dropY;
+	}
+	
+	// Same as above, but by actually moving the piece down a row at a time.
+	// For when it's underneath an overhang, and columns' tops don't help.
+	int searchDropYCoord(const Board& board) const {
+		int y = position.y - 1;
+		
+		while (y >= 0) {
+			if (fitsAbs(board, { position.x, y }))
+				y--;
+			else return ++y;
+		}
+		
+		return 0;
+	}
+	
+	// Writes the piece to the board.
+	void place(Board& board) const {
+		for (const auto& tile : getTiles()) {
+			board.setTile(tile + position, shape->color);
+		}
+	}
+};
@@ -0,0 +1,139 @@
+// Guideline Tetris!!
+// The randomizer that decides which pieces come next.
+
+#pragma once
+
+#include "pieces.hpp"
+#include "rng.hpp"
+
+#include <cstdint>
+#include <utility>
+
+// Piece Randomizer, where every piece has an equal chance of being drawn.
+// https://harddrop.com/wiki/Random_Generator
+struct PieceBag {
+	// If you display the next queue on screen, you need this buffer area--
+	// otherwise, every 7 pieces you'd have an empty queue!
+	static const int MIN_VISIBLE = 3;
+	
+	// The range of piece IDs to generate in the RNG.
+	// .first is lower bound, .second is exclusive upper bound.
+	PieceRange piecesRange = { 0, PIECE_COUNT };
+	
+	// The bag! A ring buffer, big enough for the leftovers of one set plus
+	// a whole new set. (A power of two, so wrapping around is just a mask.)
+	static const int CAPACITY = 32;
+	static_assert(CAPACITY >= MIN_VISIBLE + MAX_PIECE_COUNT, "bag can't fit a whole set");
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "bag size must be a power of two");
+	
+	int bag[CAPACITY] = { 0 };
+	int front = 0, count = 0;
+	
+	// For each queued piece: how far into its set it was dealt, and how big
+	// that set was. (Sets can change size between levels.) Someone who can
+	// only see the first few pieces can still work out which pieces are left
+	// in the set; see `sampleRestOfSet`.
+	uint8_t setPositions[CAPACITY] = { 0 };
+	uint8_t setSizes[CAPACITY] = { 0 };
+	
+	// Each bag has its own RNG, so games don't step on each other's toes,
+	// and the same seed always deals the same pieces.
+	Rng rng;
+	
+	// `range` is which pieces to start out with.
+	PieceBag(uint64_t seed = 1, PieceRange range = { 0, 7 }) : rng(seed) { reset(range); }
+	
+	void reset(PieceRange range = { 0, 7 }) {
+		front = 0; count = 0;
+		setPiecesRange(range.first, range.second);
+		pushNewSet();
+	}
+	
+	// Select which subset of the piece set the bag will take from.
+	void setPiecesRange(int lower, int upper = 0) {
+		if (lower > upper) std::swap(lower, upper);
+		if (upper == 0) return;
+		piecesRange = { lower, upper };
+	}
+	
+	// How many pieces are queued up.
+	int size() const { return count; }
+	
+	// Peeks at a queued piece without taking it. 0 is the next one.
+	int peek(int i) const {
+		return bag[(front + i) & (CAPACITY - 1)];
+	}
+	
+	// Pops a piece from the front of the queue.
+	// (Automatically gets new pieces if end of queue is then visible.)
+	int getNext() {
+		if (count <= MIN_VISIBLE)
+			pushNewSet();
+		
+		int result = bag[front];
+		front = (front + 1) & (CAPACITY - 1);
+		count--;
+		return result;
+	}
+	
+	// Pushes a new batch of pieces (one of each in the range)
+	// to the end of the queue.
+	void pushNewSet() {
+		int set[CAPACITY];
+		int rangeSize = shuffleSet(rng, piecesRange, set);
+		
+		int back = front + count;
+		for (int i = 0; i < rangeSize; i++) {
+			int slot = (back + i) & (CAPACITY - 1);
+			bag[slot] = set[i];
+			setPositions[slot] = i;
+			setSizes[slot] = rangeSize;
+		}
+		
+		count += rangeSize;
+	}
+	
+	// The pieces that are still to come from the same set as queued piece
+	// `i`, after it: which ones they are is known (every set has each piece
+	// once), but not their order, so they come out freshly shuffled with
+	// `rng`. Returns how many there are.
+	// (The whole set is always queued up at once, so they're all in here.)
+	int sampleRestOfSet(int i, Rng& rng, int* out) const {
+		int slot = (front + i) & (CAPACITY - 1);
+		int rest = setSizes[slot] - 1 - setPositions[slot];
+		for (int j = 0; j < rest; j++)
+			out[j] = peek(i + 1 + j);
+		
+		for (int j = rest - 1; j > 0; j--)
+			std::swap(out[j], out[rng.below(j + 1)]);
+		return rest;
+	}
+	
+	// Writes one shuffled set (every piece in the range, once) to `out`.
+	// Returns how many pieces that was.
+	static int shuffleSet(Rng& rng, PieceRange range, int* out) {
+		int rangeSize = range.second - range.first;
+		
+		for (int i = 0; i < rangeSize; i++)
+			out[i] = i + range.first;
+		
+		// Fisher-Yates.
+		for (int i = rangeSize - 1; i > 0; i--) {
+			int j = rng.below(i + 1);
+			std::swap(out[i], out[j]);
+		}
+		
+		return rangeSize;
+	}
+	
+	// Deals `sets` whole sets in one go, straight into `out`, for when you
+	// need lots of pieces up front (like batch simulations). `out` needs room
+	// for `sets` times the range size. This advances the bag's RNG exactly
+	// like pushing that many sets would, but leaves the queue alone.
+	int generateSets(int* out, int sets) {
+		int written = 0;
+		for (int i = 0; i < sets; i++)
+			written += shuffleSet(rng, piecesRange, out + written);
+		return written;
+	}
+};
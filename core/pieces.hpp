@@ -0,0 +1,222 @@
+// Guideline Tetris!!
+// Piece shapes, rotation tables, and the level curve.
+
+#pragma once
+
+#include "vec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+// How far any tile of any piece may be from the piece's center.
+// Collision works on (REACH * 2 + 1)-wide row masks, so don't go past this.
+const int PIECE_REACH = 2;
+
+// The most tiles a piece can have. (Pentominos!)
+const int MAX_PIECE_TILES = 5;
+
+// The most nudges SRS will try for one rotation.
+const int MAX_PIECE_KICKS = 5;
+
+// The most pieces one piece set can have.
+const int MAX_PIECE_COUNT = 28;
+
+// A piece's offset table: a list of "nudges" for each of the four rotations.
+// (Every list in a table is the same length.)
+struct PieceRotation {
+	int checks = 0;
+	Vec2i offsets[4][MAX_PIECE_KICKS] = {};
+	
+	constexpr PieceRotation() {}
+	constexpr PieceRotation(std::initializer_list<std::initializer_list<Vec2i>> table) {
+		int r = 0;
+		for (const auto& list : table) {
+			checks = (r == 0) ? list.size() : std::min<int>(checks, list.size());
+			int i = 0;
+			for (const auto& offset : list) offsets[r][i++] = offset;
+			r++;
+		}
+	}
+};
+
+// Tables from https://harddrop.com/wiki/SRS#How_Guideline_SRS_Really_Works
+constexpr PieceRotation PIECE_OFFSETS_I = {
+	{ { 0, 0}, {-1, 0}, {+2, 0}, {-1, 0}, {+2, 0} }, //   0 deg
+	{ {-1, 0}, { 0, 0}, { 0, 0}, { 0,+1}, { 0,-2} }, //  90 deg
+	{ {-1,+1}, {+1,+1}, {-2,+1}, {+1, 0}, {-2, 0} }, // 180 deg
+	{ { 0,+1}, { 0,+1}, { 0,+1}, { 0,-1}, { 0,+2} }  // 270 deg
+};
+constexpr PieceRotation PIECE_OFFSETS_JLSTZ {
+	{ { 0, 0}, { 0, 0}, { 0, 0}, { 0, 0}, { 0, 0} }, //   0 deg
+	{ { 0, 0}, {+1, 0}, {+1,-1}, { 0,+2}, {+1,+2} }, //  90 deg
+	{ { 0, 0}, { 0, 0}, { 0, 0}, { 0, 0}, { 0, 0} }, // 180 deg
+	{ { 0, 0}, {-1, 0}, {-1,-1}, { 0,+2}, {-1,+2} }  // 270 deg
+};
+constexpr PieceRotation PIECE_OFFSETS_O = {
+	{ { 0, 0}, }, //   0 deg
+	{ { 0,-1}, }, //  90 deg
+	{ {-1,-1}, }, // 180 deg
+	{ {-1, 0}, }  // 270 deg
+};
+
+// A piece consists of three things:
+struct PieceDefinition {
+	// ...a list of tiles (where {0, 0} is the center).
+	int tileCount = 0;
+	Vec2i tiles[MAX_PIECE_TILES] = {};
+	
+	// ...a list of "nudges" to try, in order, to make piece rotation easier
+	const PieceRotation* rotations = nullptr;
+	
+	// ...a tile "color" (pretty much just an index into `images/tiles.png`)
+	int color = 0;
+	
+	constexpr PieceDefinition() {}
+	constexpr PieceDefinition(std::initializer_list<Vec2i> tiles, const PieceRotation* rotations, int color)
+		: tileCount(tiles.size()), rotations(rotations), color(color) {
+		int i = 0;
+		for (const auto& tile : tiles) this->tiles[i++] = tile;
+	}
+	
+	// Returns the length of the nudge list.
+	constexpr int getOffsetCheckLength(int /*prevRotation*/, int /*nextRotation*/) const {
+		return rotations->checks;
+	}
+	
+	// Computes an actual nudge direction, because SRS is bizarre.
+	constexpr Vec2i getOffset(int prevRotation, int nextRotation, int check) const {
+		return rotations->offsets[prevRotation][check] - rotations->offsets[nextRotation][check];
+	}
+};
+
+// List of pieces.
+// (More can be loaded at run time, see pieceset.hpp.)
+constexpr PieceDefinition PIECE_DEFINITIONS[] = {
+	// Standard Tetrominos
+	{ { {0, 0}, {-1, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_I,     5 }, // I
+	{ { {0, 0}, {-1,+1}, {-1, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 7 }, // J
+	{ { {0, 0}, {+1,+1}, {-1, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 6 }, // L
+	{ { {0, 0}, { 0,+1}, {+1,+1}, {+1, 0} }, &PIECE_OFFSETS_O,     4 }, // O (non-standard)
+	{ { {0, 0}, { 0,+1}, {+1,+1}, {-1, 0} }, &PIECE_OFFSETS_JLSTZ, 3 }, // S
+	{ { {0, 0}, { 0,+1}, {-1, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 1 }, // T
+	{ { {0, 0}, {-1,+1}, { 0,+1}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 2 }, // Z
+	
+	// Funny Pentominos
+	// (I made up some of the names for these, they're very non-standard)
+	{ { {-2, 0}, {-1, 0}, { 0, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_JLSTZ, 5 }, // It
+	{ { { 0,+1}, { 0, 0}, {-1,-1}, { 0,-1}, {+1,-1} }, &PIECE_OFFSETS_JLSTZ, 1 }, // Tt
+	{ { {-1,+1}, {+1,+1}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 4 }, // U
+	{ { {-1,+1}, {-1, 0}, {-1,-1}, { 0,-1}, {+1,-1} }, &PIECE_OFFSETS_JLSTZ, 6 }, // V
+	{ { {-1,+1}, {-1, 0}, { 0, 0}, { 0,-1}, {+1,-1} }, &PIECE_OFFSETS_JLSTZ, 2 }, // W
+	{ { { 0,+1}, {-1, 0}, { 0, 0}, {+1, 0}, { 0,-1} }, &PIECE_OFFSETS_JLSTZ, 4 }, // X
+	{ { {-1,+1}, {-1, 0}, { 0, 0}, {+1, 0}, { 0,-1} }, &PIECE_OFFSETS_JLSTZ, 7 }, // F
+	{ { {+1,+1}, {-1, 0}, { 0, 0}, {+1, 0}, { 0,-1} }, &PIECE_OFFSETS_JLSTZ, 6 }, // Ff
+	{ { { 0,+1}, {+1,+1}, { 0, 0}, {-1,-1}, { 0,-1} }, &PIECE_OFFSETS_JLSTZ, 3 }, // St
+	{ { {-1,+1}, { 0,+1}, { 0, 0}, { 0,-1}, {+1,-1} }, &PIECE_OFFSETS_JLSTZ, 2 }, // Zt
+	{ { {-1,+1}, {-1, 0}, { 0, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_JLSTZ, 7 }, // Jt
+	{ { {+1,+1}, {-2, 0}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 6 }, // Lt
+	{ { { 0,+1}, {-1, 0}, { 0, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_JLSTZ, 5 }, // Yf
+	{ { { 0,+1}, {-2, 0}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 5 }, // Y
+	{ { { 0,+1}, {+1,+1}, {-2, 0}, {-1, 0}, { 0, 0} }, &PIECE_OFFSETS_JLSTZ, 3 }, // Sw
+	{ { {-1,+1}, { 0,+1}, { 0, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_JLSTZ, 2 }, // Zw
+	{ { {-1,+1}, { 0,+1}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 4 }, // P
+	{ { { 0,+1}, {+1,+1}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 4 }  // Q
+};
+constexpr int PIECE_COUNT = std::size(PIECE_DEFINITIONS);
+static_assert(PIECE_COUNT <= MAX_PIECE_COUNT, "too many built-in pieces");
+
+// Packs an opaque color into an integer.
+constexpr uint32_t packColor(int r, int g, int b) {
+	return (uint32_t)r << 24 | (uint32_t)g << 16 | (uint32_t)b << 8 | 0xFF;
+}
+
+// A range of piece IDs. `first` is included, `second` isn't.
+// (Not a `std::pair`, since that isn't trivially copyable, and games have
+// to be; see game.hpp.)
+struct PieceRange {
+	int first, second;
+};
+
+// Which pieces spawn, from `level` on (until the next stage starts).
+// The range can grow as the levels go by: `last` goes up by one every
+// `growEvery` levels, until it gets to `maxLast`. (0 means it doesn't grow.)
+struct PieceStage {
+	int level;
+	int first, last; // like `piecesRange`: last is exclusive
+	int growEvery;
+	int maxLast;
+};
+
+// tried to be mindful about when things happen in this game.
+// https://www.desmos.com/calculator/mktrzc7bs9
+// and to see pretty much everything in this game,
+// you just have to clear 120 lines.
+constexpr PieceStage PIECE_STAGES[] = {
+	{  0, 0,  7, 0,  7 },
+	// once level 10 rolls around, start spawning pentominos
+	{ 10, 0,  7, 2, 19 },
+	// if you're this far, you don't need tetrominos any more.
+	{ 35, 7, 19, 0, 19 },
+};
+
+// The range of pieces to spawn on a level. (Stages go in order of level,
+// and the first one starts at 0.)
+inline PieceRange getPiecesRange(int index, const PieceStage* stages, int stageCount) {
+	const PieceStage* stage = stages;
+	for (int i = 1; i < stageCount && stages[i].level <= index; i++)
+		stage = &stages[i];
+	
+	int last = stage->last;
+	if (stage->growEvery > 0)
+		last = std::min(last + (index - stage->level) / stage->growEvery, stage->maxLast);
+	return { stage->first, last };
+}
+
+struct Level {
+	// how fast a piece falls.
+	float fallDelay;
+	
+	// how fast a piece locks in place.
+	float lockDelay;
+	
+	// which range of pieces from the piece set to spawn.
+	PieceRange piecesRange;
+	
+	// what color the background is. (0xRRGGBBAA, like `sf::Color` takes.)
+	uint32_t bgColor;
+};
+
+// (Piece sets have their own stages; see `getLevel(int, const PieceSet&)`.)
+inline Level getLevel(int index, const PieceStage* stages = PIECE_STAGES, int stageCount = std::size(PIECE_STAGES)) {
+	return Level({
+		(float)std::max(0.2, 0.4 - (float)index * 0.01),
+		(float)std::max(0.3, 0.7 - (float)index * 0.01),
+		getPiecesRange(index, stages, stageCount),
+		packColor(
+			255, // meant to later look like a sunset,
+			// then later look like the sky is blood red.
+			std::min(std::max(96, 260 - index * 3), 255),
+			std::min(std::max(80, 270 - index * 4), 255)
+		)
+	});
+}
+
+// Rotates a vector in 90 degree increments.
+// `rotation` is given in these 90deg increments, so ±2 means 180 degrees.
+constexpr Vec2i rotate(const Vec2i& v, int rotation) {
+	// restricts range to 0, 1, 2, 3
+	// (or -1, 0, 1, ±2 if you're signed)
+	rotation &= 3;
+	
+	switch (rotation) {
+		default: case 0: return { v.x, v.y };
+		break; case 1: return { +v.y, -v.x };
+		break; case 2: return { -v.x, -v.y };
+		break; case 3: return { -v.y, +v.x };
+		break;
+	}
+}
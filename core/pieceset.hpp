@@ -0,0 +1,293 @@
+// Guideline Tetris!!
+// Sets of pieces, either the built-in ones or loaded from a file.
+
+#pragma once
+
+#include "mappedfile.hpp"
+#include "pieces.hpp"
+#include "piecetables.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+// How many tiles there are in `images/tiles.png`. (Tile 0 is empty space,
+// so pieces get the rest.)
+const int TILE_COLORS = 8;
+
+// Garbage lines (see versus.hpp) use the one after those, so they can be
+// told apart from pieces. (Drawing picks some tile for them.)
+const int GARBAGE_TILE = TILE_COLORS;
+
+// Every piece of a set, already turned into the same `PieceShape` tables the
+// built-in pieces use, so a loaded piece is just as quick as a built-in one.
+// Piece IDs are indices into `shapes`.
+//
+// Piece set files are plain text, made of words and numbers separated by
+// any whitespace. `#` starts a comment, to the end of the line.
+//
+//   kicks <name> <checks>  <x y> ...
+//       An SRS offset table: `checks` offsets for rotation 0, then for 90,
+//       180 and 270 degrees. "i", "jlstz" and "o" are already there.
+//   piece <name> <color> <kicks> <tiles>  <x y> ...
+//       A piece: a color (which tile in the texture), which offset table to
+//       rotate with, and its tiles (where {0, 0} is the center). The tiles
+//       have to reach the center's row and column, from both sides or
+//       through it.
+//   stage <level> <first> <last> <grow every> <max last>
+//       Which pieces spawn from `level` on; see `PieceStage`. Without any,
+//       every piece spawns from the start.
+//
+// Names are only for reading the file; pieces get IDs in the order they show
+// up. (See pieces/tetrominos.txt.)
+struct PieceSet {
+	static const int MAX_STAGES = 16;
+	
+	int count = 0;
+	PieceShape shapes[MAX_PIECE_COUNT] = {};
+	
+	int stageCount = 0;
+	PieceStage stages[MAX_STAGES] = {};
+	
+	constexpr const PieceShape& getShape(int id) const { return shapes[id]; }
+	
+	// Reads a piece set file. On failure, says what went wrong in `error`
+	// (with the line number), and leaves the set as it was.
+	bool load(const char* path, char* error, size_t errorSize);
+	
+	// A fingerprint of everything that changes how the set plays: the
+	// tiles, the kicks and the stages. (Not the colors.) Replays keep it, so
+	// they only get played back with the pieces they were recorded with.
+	uint64_t getHash() const;
+};
+
+// The pieces from PIECE_DEFINITIONS, with the usual level curve.
+constexpr PieceSet buildBuiltInPieceSet() {
+	PieceSet set;
+	set.count = PIECE_COUNT;
+	for (int i = 0; i < PIECE_COUNT; i++)
+		set.shapes[i] = buildPieceShape(PIECE_DEFINITIONS[i]);
+	
+	set.stageCount = std::size(PIECE_STAGES);
+	for (int i = 0; i < set.stageCount; i++)
+		set.stages[i] = PIECE_STAGES[i];
+	return set;
+}
+
+constexpr PieceSet BUILT_IN_PIECE_SET = buildBuiltInPieceSet();
+
+// The level curve, with the piece set's own idea of which pieces spawn when.
+inline Level getLevel(int index, const PieceSet& set) {
+	return getLevel(index, set.stages, set.stageCount);
+}
+
+namespace pieceset {
+	// Splits a file up into words, skipping whitespace and comments.
+	struct Tokenizer {
+		const char* cursor;
+		const char* end;
+		int line = 1;
+		
+		// Returns false at the end of the file.
+		bool nextWord(char* word, int maxLength) {
+			for (;;) {
+				while (cursor < end && strchr(" \t\r\n", *cursor)) {
+					if (*cursor == '\n') line++;
+					cursor++;
+				}
+				if (cursor < end && *cursor == '#') {
+					while (cursor < end && *cursor != '\n') cursor++;
+					continue;
+				}
+				break;
+			}
+			if (cursor == end) return false;
+			
+			int length = 0;
+			while (cursor < end && !strchr(" \t\r\n#", *cursor)) {
+				if (length < maxLength - 1) word[length++] = *cursor;
+				cursor++;
+			}
+			word[length] = 0;
+			return true;
+		}
+		
+		bool nextInt(int& value) {
+			char word[16];
+			if (!nextWord(word, sizeof(word))) return false;
+			
+			char* wordEnd;
+			long parsed = strtol(word, &wordEnd, 10);
+			if (wordEnd == word || *wordEnd != 0 || parsed < -9999 || parsed > 9999) return false;
+			value = parsed;
+			return true;
+		}
+	};
+	
+	const int NAME_LENGTH = 16;
+	const int MAX_KICK_TABLES = 16;
+	
+	struct NamedKicks {
+		char name[NAME_LENGTH];
+		PieceRotation rotation;
+	};
+}
+
+inline bool PieceSet::load(const char* path, char* error, size_t errorSize) {
+	using namespace pieceset;
+	
+	MappedFile file;
+	if (!file.open(path)) {
+		snprintf(error, errorSize, "%s: can't read it (or it's empty)", path);
+		return false;
+	}
+	
+	Tokenizer tokens = { (const char*)file.data, (const char*)file.data + file.size };
+	
+	// Everything goes into a new set first, so a bad file doesn't leave
+	// this one half-overwritten.
+	PieceSet loaded;
+	
+	NamedKicks kickTables[MAX_KICK_TABLES] = {
+		{ "i",     PIECE_OFFSETS_I },
+		{ "jlstz", PIECE_OFFSETS_JLSTZ },
+		{ "o",     PIECE_OFFSETS_O },
+	};
+	int kickTableCount = 3;
+	
+	auto fail = [&](const char* message) {
+		snprintf(error, errorSize, "%s:%d: %s", path, tokens.line, message);
+		return false;
+	};
+	
+	char word[NAME_LENGTH];
+	while (tokens.nextWord(word, sizeof(word))) {
+		if (!strcmp(word, "kicks")) {
+			if (kickTableCount == MAX_KICK_TABLES) return fail("too many kick tables");
+			NamedKicks& table = kickTables[kickTableCount++];
+			
+			int checks;
+			if (!tokens.nextWord(table.name, sizeof(table.name))) return fail("kick table needs a name");
+			if (!tokens.nextInt(checks) || checks < 1 || checks > MAX_PIECE_KICKS) return fail("bad number of checks");
+			
+			table.rotation.checks = checks;
+			for (int r = 0; r < 4; r++) {
+				for (int i = 0; i < checks; i++) {
+					Vec2i& offset = table.rotation.offsets[r][i];
+					if (!tokens.nextInt(offset.x) || !tokens.nextInt(offset.y)) return fail("bad offset");
+				}
+			}
+		} else if (!strcmp(word, "piece")) {
+			if (loaded.count == MAX_PIECE_COUNT) return fail("too many pieces");
+			
+			char name[NAME_LENGTH], kicksName[NAME_LENGTH];
+			PieceDefinition definition;
+			if (!tokens.nextWord(name, sizeof(name))) return fail("piece needs a name");
+			if (!tokens.nextInt(definition.color) || definition.color < 1 || definition.color >= TILE_COLORS)
+				return fail("bad color");
+			if (!tokens.nextWord(kicksName, sizeof(kicksName))) return fail("piece needs a kick table");
+			
+			for (int i = 0; i < kickTableCount; i++)
+				if (!strcmp(kickTables[i].name, kicksName))
+					definition.rotations = &kickTables[i].rotation;
+			if (!definition.rotations) return fail("no kick table by that name");
+			
+			if (!tokens.nextInt(definition.tileCount) || definition.tileCount < 1 || definition.tileCount > MAX_PIECE_TILES)
+				return fail("bad number of tiles");
+			for (int i = 0; i < definition.tileCount; i++) {
+				Vec2i& tile = definition.tiles[i];
+				if (!tokens.nextInt(tile.x) || !tokens.nextInt(tile.y)) return fail("bad tile");
+				
+				// Collision only looks this far out from the center.
+				if (abs(tile.x) > PIECE_REACH || abs(tile.y) > PIECE_REACH) return fail("tile too far from the center");
+				for (int j = 0; j < i; j++)
+					if (definition.tiles[j] == tile) return fail("same tile twice");
+			}
+			
+			// Collision takes a center that's off the board to mean the piece
+			// is too (see `Piece::fitsAbs`), which only holds if it has tiles
+			// on both sides of the center, or in line with it, both ways.
+			Vec2i low = definition.tiles[0], high = definition.tiles[0];
+			for (int i = 1; i < definition.tileCount; i++) {
+				const Vec2i& tile = definition.tiles[i];
+				low = { std::min(low.x, tile.x), std::min(low.y, tile.y) };
+				high = { std::max(high.x, tile.x), std::max(high.y, tile.y) };
+			}
+			if (low.x > 0 || high.x < 0 || low.y > 0 || high.y < 0)
+				return fail("tiles have to be on both sides of the center (or in line with it)");
+			
+			loaded.shapes[loaded.count++] = buildPieceShape(definition);
+		} else if (!strcmp(word, "stage")) {
+			if (loaded.stageCount == MAX_STAGES) return fail("too many stages");
+			
+			PieceStage& stage = loaded.stages[loaded.stageCount++];
+			if (!tokens.nextInt(stage.level) || !tokens.nextInt(stage.first) || !tokens.nextInt(stage.last)
+			||  !tokens.nextInt(stage.growEvery) || !tokens.nextInt(stage.maxLast))
+				return fail("stage needs five numbers");
+			
+			// (Pieces can be defined after the stages, so ranges get checked later.)
+			int previous = loaded.stageCount == 1 ? -1 : loaded.stages[loaded.stageCount - 2].level;
+			if (loaded.stageCount == 1 && stage.level != 0) return fail("first stage has to start at level 0");
+			if (stage.level <= previous) return fail("stages have to go in order");
+			if (stage.growEvery < 0 || stage.maxLast < stage.last) return fail("bad growth");
+		} else {
+			return fail("expected kicks, piece or stage");
+		}
+	}
+	
+	if (loaded.count == 0) return fail("no pieces");
+	
+	if (loaded.stageCount == 0)
+		loaded.stages[loaded.stageCount++] = { 0, 0, loaded.count, 0, loaded.count };
+	
+	for (int i = 0; i < loaded.stageCount; i++) {
+		const PieceStage& stage = loaded.stages[i];
+		if (stage.first < 0 || stage.first >= stage.last || stage.maxLast > loaded.count) {
+			snprintf(error, errorSize, "%s: stage at level %d spawns pieces that aren't there", path, stage.level);
+			return false;
+		}
+	}
+	
+	*this = loaded;
+	return true;
+}
+
+// FNV-1a, like replay checksums.
+inline uint64_t PieceSet::getHash() const {
+	uint64_t hash = 0xCBF29CE484222325;
+	auto mix = [&hash](int value) {
+		for (int i = 0; i < 4; i++) {
+			hash ^= ((uint32_t)value >> (i * 8)) & 0xFF;
+			hash *= 0x100000001B3;
+		}
+	};
+	
+	mix(count);
+	for (int id = 0; id < count; id++) {
+		const PieceShape& shape = shapes[id];
+		mix(shape.tileCount);
+		for (int r = 0; r < 4; r++)
+			for (const Vec2i& tile : shape.getTiles(r)) {
+				mix(tile.x);
+				mix(tile.y);
+			}
+		
+		mix(shape.kickCount);
+		for (int from = 0; from < 4; from++)
+			for (int to = 0; to < 4; to++)
+				for (int i = 0; i < shape.kickCount; i++) {
+					mix(shape.kicks[from][to][i].x);
+					mix(shape.kicks[from][to][i].y);
+				}
+	}
+	
+	mix(stageCount);
+	for (int i = 0; i < stageCount; i++) {
+		const PieceStage& stage = stages[i];
+		mix(stage.level); mix(stage.first); mix(stage.last); mix(stage.growEvery); mix(stage.maxLast);
+	}
+	return hash;
+}
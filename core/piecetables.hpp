@@ -0,0 +1,88 @@
+// Guideline Tetris!!
+// Everything about a piece that can be worked out ahead of time,
+// worked out ahead of time. (At compile time for the built-in pieces,
+// and at load time for piece sets.)
+
+#pragma once
+
+#include "pieces.hpp"
+#include "vec.hpp"
+
+#include <cstdint>
+
+// A piece in all four of its rotations, ready to be tested against a board.
+struct PieceShape {
+	// Row masks are this many rows tall, centered on the piece.
+	static const int MASK_ROWS = PIECE_REACH * 2 + 1;
+	
+	int tileCount = 0;
+	int color = 0;
+	
+	// The tiles, relative to the piece's position, for each rotation.
+	Vec2i tiles[4][MAX_PIECE_TILES] = {};
+	
+	// The tiles as row bitmasks, for fast collision against the board.
+	// `rowMasks[r][PIECE_REACH + dy]` has bit (PIECE_REACH + dx) set
+	// for each tile {dx, dy} in rotation `r`.
+	uint16_t rowMasks[4][MASK_ROWS] = {};
+	
+	// The lowest tile in each column, for dropping without searching.
+	// `bottoms[r][PIECE_REACH + dx]` is the lowest dy of any tile {dx, dy}
+	// in rotation `r`, or NO_TILE if that column has none.
+	static const int COLUMNS = PIECE_REACH * 2 + 1;
+	static const int NO_TILE = PIECE_REACH + 1;
+	int8_t bottoms[4][COLUMNS] = {};
+	
+	// The SRS nudges to try when rotating from one rotation to another,
+	// already subtracted. Every (from, to) pair has `kickCount` of them.
+	int kickCount = 0;
+	Vec2i kicks[4][4][MAX_PIECE_KICKS] = {};
+	
+	// How far down any one of those nudges goes.
+	int maxKickDrop = 0;
+	
+	// Lets you write `for (const auto& tile : shape.getTiles(rotation))`.
+	struct TileList {
+		const Vec2i* first;
+		const Vec2i* last;
+		
+		constexpr const Vec2i* begin() const { return first; }
+		constexpr const Vec2i* end() const { return last; }
+	};
+	
+	constexpr TileList getTiles(int rotation) const {
+		return { tiles[rotation], tiles[rotation] + tileCount };
+	}
+};
+
+// Works out the tables for one piece.
+constexpr PieceShape buildPieceShape(const PieceDefinition& definition) {
+	PieceShape shape;
+	shape.tileCount = definition.tileCount;
+	shape.color = definition.color;
+	
+	for (int r = 0; r < 4; r++) {
+		for (int i = 0; i < PieceShape::COLUMNS; i++)
+			shape.bottoms[r][i] = PieceShape::NO_TILE;
+		
+		for (int i = 0; i < definition.tileCount; i++) {
+			Vec2i tile = rotate(definition.tiles[i], r);
+			shape.tiles[r][i] = tile;
+			shape.rowMasks[r][PIECE_REACH + tile.y] |= 1 << (PIECE_REACH + tile.x);
+			
+			int8_t& bottom = shape.bottoms[r][PIECE_REACH + tile.x];
+			if (tile.y < bottom) bottom = tile.y;
+		}
+	}
+	
+	shape.kickCount = definition.getOffsetCheckLength(0, 0);
+	for (int from = 0; from < 4; from++)
+		for (int to = 0; to < 4; to++)
+			for (int i = 0; i < shape.kickCount; i++) {
+				Vec2i kick = definition.getOffset(from, to, i);
+				shape.kicks[from][to][i] = kick;
+				if (-kick.y > shape.maxKickDrop) shape.maxKickDrop = -kick.y;
+			}
+	
+	return shape;
+}
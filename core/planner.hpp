@@ -0,0 +1,285 @@
+// Guideline Tetris!!
+// Picks the falling piece's spot by playing it out through lots of guessed
+// futures, across every core at once.
+
+#pragma once
+
+#include "board.hpp"
+#include "bot.hpp"
+#include "evaluate.hpp"
+#include "game.hpp"
+#include "piecebag.hpp"
+#include "pieceset.hpp"
+#include "rng.hpp"
+#include "transposition.hpp"
+#include "worksteal.hpp"
+#include "zobrist.hpp"
+
+#include <chrono>
+#include <memory>
+
+// Only the first few pieces of the queue can be seen, but the bag (see
+// piecebag.hpp) gives a lot away about the rest: whatever's left of the set
+// the last visible piece came from is known, just not in what order, and
+// after that come whole fresh sets. So one "sample" is one way the future
+// could go: the visible pieces, then the rest of that set shuffled, then
+// freshly shuffled sets, `horizon` pieces in all. (Sets can be anything up
+// to MAX_PIECE_COUNT pieces, like the 19 of the later levels.)
+//
+// Every spot the bot could drop the falling piece into gets played forward
+// through each sample, the way the bot would play it (the best board one
+// piece at a time), and the spot that does best on average wins. The
+// visible pieces are the same in every sample, so each spot's path through
+// those only gets played once.
+//
+// Samples run on every worker of the pool at once, each with its own RNG
+// and scratch space, set up ahead of time so planning never allocates, and
+// keep coming until the time's up. How a playout goes only depends on the
+// board and the pieces left, so they go in a shared TranspositionTable too:
+// samples that guess the same pieces, and spots that lead to the same
+// board, only get played out once.
+struct MonteCarloPlanner {
+	// Every rotation in every column, at most.
+	static const int MAX_ROOTS = 4 * Board::WIDTH;
+	
+	static const int MAX_HORIZON = 24;
+	static_assert(MAX_HORIZON < zobrist::QUEUE_SLOTS, "not enough zobrist keys for the horizon");
+	
+	// What a spot's worth if the game ends along the way.
+	static constexpr float TOPPED_OUT = -1e9f;
+	
+	// How many pieces after the falling one each sample plays out.
+	int horizon = 8;
+	
+	// How long to spend on each piece, in seconds, and/or how many samples
+	// each worker gets at most. (0 means no limit on that one. Without a time
+	// limit, the same game always gets the same plans.)
+	double budget = 0.010;
+	int maxSamplesPerWorker = 0;
+	
+	EvalWeights weights = NEAR_PERFECT_WEIGHTS;
+	
+	// Shared with whoever else is planning, or none. (Not with a
+	// LookaheadSearch, though: the same keys mean something else there.)
+	TranspositionTable* table = nullptr;
+	
+	// Counts, since this was made.
+	long int plans = 0;
+	long int samples = 0;   // futures guessed
+	long int playouts = 0;  // spots played through them
+	long int tableHits = 0; // positions whose playouts were in the table
+	
+	struct Choice {
+		bool found = false;
+		int rotation = 0, x = 0; // like Bot::Drop
+		float score = TOPPED_OUT; // on average
+	};
+	
+	MonteCarloPlanner(WorkStealingPool& pool, uint64_t seed = 1, TranspositionTable* table = nullptr)
+		: table(table), pool(pool), laneCount(pool.getThreadCount()), lanes(new Lane[laneCount]), seeds(seed) {}
+	
+	// Picks where the falling piece should go.
+	Choice plan(const Game& game) {
+		auto start = Clock::now();
+		set = game.pieceSet;
+		if (horizon > MAX_HORIZON) horizon = MAX_HORIZON;
+		if (table) table->newSearch();
+		
+		// Every spot the piece can go, and how each one plays through the
+		// pieces everybody can see.
+		rootCount = 0;
+		Bot::forEachDrop(game.board, game.piece, [&](const Piece& dropped, int rotation, int x) {
+			Root& root = roots[rootCount++];
+			root.rotation = rotation;
+			root.x = x;
+			root.board = game.board;
+			dropped.place(root.board);
+			root.gained = weights.lines * clear(root.board, dropped);
+			root.toppedOut = false;
+		});
+		
+		Choice choice;
+		if (rootCount == 0) return choice;
+		
+		knownCount = game.bag.size() < PieceBag::MIN_VISIBLE ? game.bag.size() : PieceBag::MIN_VISIBLE;
+		if (knownCount > horizon) knownCount = horizon;
+		for (int i = 0; i < knownCount; i++) known[i] = game.bag.peek(i);
+		
+		auto playKnown = [this](int r, int) {
+			Root& root = roots[r];
+			for (int i = 0; i < knownCount && !root.toppedOut; i++) {
+				Bot::Drop drop = Bot::findBestDrop(root.board, Piece(known[i], *set), weights);
+				if (!drop.found) {
+					root.toppedOut = true;
+					break;
+				}
+				drop.piece.place(root.board);
+				root.gained += weights.lines * clear(root.board, drop.piece);
+			}
+		};
+		pool.run(rootCount, playKnown);
+		
+		// Then everybody samples until it's time to stop.
+		auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(budget));
+		uint64_t planSeed = (uint64_t)seeds.next() << 32 | seeds.next();
+		
+		auto sample = [&](int index, int) {
+			Lane& lane = lanes[index];
+			lane.rng.reseed(planSeed + index);
+			lane.samples = lane.playouts = lane.hits = 0;
+			for (int r = 0; r < rootCount; r++) lane.sums[r] = 0;
+			
+			do {
+				int count = guessFuture(game.bag, lane);
+				for (int r = 0; r < rootCount; r++) {
+					if (roots[r].toppedOut) continue;
+					lane.sums[r] += playOut(roots[r].board, lane.pieces + knownCount, count - knownCount, lane);
+				}
+				lane.samples++;
+			} while (keepSampling(lane, deadline));
+		};
+		pool.run(laneCount, sample);
+		
+		// Everybody's samples, all together.
+		long int planSamples = 0;
+		for (int i = 0; i < laneCount; i++) {
+			planSamples += lanes[i].samples;
+			playouts += lanes[i].playouts;
+			tableHits += lanes[i].hits;
+		}
+		plans++;
+		samples += planSamples;
+		
+		for (int r = 0; r < rootCount; r++) {
+			double sum = 0;
+			for (int i = 0; i < laneCount; i++) sum += lanes[i].sums[r];
+			
+			float score = roots[r].toppedOut ? TOPPED_OUT : roots[r].gained + sum / planSamples;
+			if (!choice.found || score > choice.score) {
+				choice.found = true;
+				choice.rotation = roots[r].rotation;
+				choice.x = roots[r].x;
+				choice.score = score;
+			}
+		}
+		return choice;
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+	
+	// Keeps playouts' keys apart from LookaheadSearch's.
+	static const uint64_t KEY_SALT = 0x4D43504C414E4E52; // "MCPLANNR"
+	
+	struct Root {
+		int rotation, x;
+		Board board;  // after the visible pieces, too
+		float gained; // for the lines that took
+		bool toppedOut;
+	};
+	
+	// One worker's worth of sampling. (A cache line apart from the others,
+	// so they don't slow each other down.)
+	struct alignas(64) Lane {
+		Rng rng;
+		double sums[MAX_ROOTS];
+		long int samples, playouts, hits;
+		
+		// A guessed future. Sets get dealt whole, so there's room for one
+		// more than fits in the horizon.
+		int pieces[PieceBag::MIN_VISIBLE + MAX_PIECE_COUNT + MAX_HORIZON + MAX_PIECE_COUNT];
+	};
+	
+	WorkStealingPool& pool;
+	int laneCount;
+	std::unique_ptr<Lane[]> lanes;
+	Rng seeds;
+	
+	const PieceSet* set = &BUILT_IN_PIECE_SET;
+	Root roots[MAX_ROOTS];
+	int rootCount = 0;
+	int known[PieceBag::MIN_VISIBLE];
+	int knownCount = 0;
+	
+	bool keepSampling(const Lane& lane, Clock::time_point deadline) const {
+		if (maxSamplesPerWorker > 0 && lane.samples >= maxSamplesPerWorker) return false;
+		if (budget > 0) return Clock::now() < deadline;
+		return maxSamplesPerWorker > 0;
+	}
+	
+	// Clears whatever lines a piece that just got placed filled.
+	static int clear(Board& board, const Piece& placed) {
+		return board.clearLines(placed.position.y - PIECE_REACH, placed.position.y + PIECE_REACH).count;
+	}
+	
+	// Writes one possible future into `lane.pieces`: the visible pieces,
+	// the rest of the last one's set, then new sets. Returns how many pieces
+	// of it to play (the horizon).
+	int guessFuture(const PieceBag& bag, Lane& lane) const {
+		int count = 0;
+		for (int i = 0; i < knownCount; i++) lane.pieces[count++] = known[i];
+		if (knownCount > 0)
+			count += bag.sampleRestOfSet(knownCount - 1, lane.rng, lane.pieces + count);
+		while (count < horizon)
+			count += PieceBag::shuffleSet(lane.rng, bag.piecesRange, lane.pieces + count);
+		return horizon;
+	}
+	
+	// How the bot would do from `start`, playing `pieces` in order: the
+	// lines it clears on the way, plus how good the last board is.
+	float playOut(const Board& start, const int* pieces, int count, Lane& lane) {
+		lane.playouts++;
+		
+		// Every position along the way, and what its piece's lines were worth.
+		uint64_t keys[MAX_HORIZON + 1];
+		float gained[MAX_HORIZON + 1];
+		
+		Board board = start;
+		float value = 0;
+		bool cached = false;
+		int level = 0;
+		for (;; level++) {
+			uint64_t key = board.hash ^ KEY_SALT;
+			for (int i = level; i < count; i++)
+				key ^= zobrist::piece(i - level, pieces[i]);
+			keys[level] = key;
+			
+			TranspositionTable::Result result;
+			if (table && table->probe(key, result) && result.depth == count - level + 1) {
+				value = result.score;
+				cached = true;
+				lane.hits++;
+				break;
+			}
+			
+			if (level == count) {
+				value = evaluateBoard(board);
+				break;
+			}
+			
+			Bot::Drop drop = Bot::findBestDrop(board, Piece(pieces[level], *set), weights);
+			if (!drop.found) {
+				value = TOPPED_OUT;
+				break;
+			}
+			drop.piece.place(board);
+			gained[level] = weights.lines * clear(board, drop.piece);
+		}
+		
+		// Back up the way it came, saving what every position was worth.
+		for (int l = level; l >= 0; l--) {
+			if (l < level) value += gained[l];
+			if (table && !(cached && l == level)) table->store(keys[l], { value, count - l + 1 });
+		}
+		return value;
+	}
+	
+	// Just the one board (with no lines cleared).
+	float evaluateBoard(const Board& board) const {
+		BoardBatch batch;
+		float scores[BoardBatch::LANES];
+		batch.add(board, 0);
+		scoreBatch(batch, weights, scores);
+		return scores[0];
+	}
+};
@@ -0,0 +1,361 @@
+// Guideline Tetris!!
+// Recording games, and playing them back.
+
+// A replay is just the bag's seed plus every step's input and delta time.
+// The game is deterministic, so that's enough to get the exact same game.
+// (As long as it's played with the same pieces, so the piece set's hash
+// goes in too; see `PieceSet::getHash`.)
+//
+// File layout (everything little-endian):
+//   "NTRP"      magic
+//   u8          version
+//   u64         seed
+//   u64         piece set hash (since version 2)
+//   records...  (see below)
+//   footer      (fixed size, at the very end of the file)
+//     u8        END_MARKER
+//     u64       frames
+//     i64       final score
+//     i32       final lines
+//     i64       pieces placed
+//     u64       checksum of the seed and everything above in the footer
+//
+// Each record is one step (or a run of identical steps), starting with a
+// flags byte. Only what changed since the last record gets written:
+//   INPUT_CHANGED  a u16 follows: the packed input, XORed with the last one
+//   DT_CHANGED     a u32 follows: the new dt's float bits
+//   REPEATS        a varint follows: how many more times this step repeats
+
+#pragma once
+
+#include "game.hpp"
+#include "mappedfile.hpp"
+#include "pieceset.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace replay {
+	const uint8_t MAGIC[4] = { 'N', 'T', 'R', 'P' };
+	const uint8_t VERSION = 2;
+	
+	const uint8_t INPUT_CHANGED = 1 << 0;
+	const uint8_t DT_CHANGED    = 1 << 1;
+	const uint8_t REPEATS       = 1 << 2;
+	const uint8_t END_MARKER    = 1 << 7;
+	
+	const size_t HEADER_SIZE = 4 + 1 + 8 + 8;
+	const size_t FOOTER_SIZE = 1 + 8 + 8 + 4 + 8 + 8;
+	
+	inline uint32_t floatBits(float f) {
+		uint32_t bits;
+		memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	}
+	
+	inline float bitsFloat(uint32_t bits) {
+		float f;
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+	
+	// FNV-1a over the game's final numbers.
+	inline uint64_t checksum(uint64_t seed, uint64_t frames, int64_t score, int32_t lines, int64_t pieces) {
+		uint64_t hash = 0xCBF29CE484222325;
+		auto mix = [&hash](uint64_t value, int bytes) {
+			for (int i = 0; i < bytes; i++) {
+				hash ^= (value >> (i * 8)) & 0xFF;
+				hash *= 0x100000001B3;
+			}
+		};
+		mix(seed, 8); mix(frames, 8); mix(score, 8); mix((uint32_t)lines, 4); mix(pieces, 8);
+		return hash;
+	}
+}
+
+// Writes a replay as the game is played, through its own buffer,
+// so recording costs about nothing per frame.
+struct ReplayWriter {
+	static const size_t BUFFER_SIZE = 1 << 16;
+	
+	FILE* file = nullptr;
+	uint8_t buffer[BUFFER_SIZE];
+	size_t used = 0;
+	
+	uint64_t seed = 0;
+	uint64_t frames = 0;
+	
+	// What the last written record left the reader with.
+	uint16_t lastInput = 0;
+	uint32_t lastDt = 0;
+	
+	// The step waiting to be written, and how many times it's repeated since.
+	bool havePending = false;
+	uint16_t pendingInput = 0;
+	uint32_t pendingDt = 0;
+	uint64_t pendingRepeats = 0;
+	
+	ReplayWriter() {}
+	ReplayWriter(const ReplayWriter&) = delete;
+	ReplayWriter& operator=(const ReplayWriter&) = delete;
+	~ReplayWriter() { if (file) fclose(file); }
+	
+	bool isOpen() const { return file != nullptr; }
+	
+	bool open(const char* path, uint64_t gameSeed, const PieceSet& set = BUILT_IN_PIECE_SET) {
+		file = fopen(path, "wb");
+		if (!file) return false;
+		
+		seed = gameSeed;
+		frames = 0;
+		lastInput = 0; lastDt = 0;
+		havePending = false;
+		
+		putBytes(replay::MAGIC, 4);
+		put(replay::VERSION, 1);
+		put(seed, 8);
+		put(set.getHash(), 8);
+		return true;
+	}
+	
+	// Call once per `Game::step`, with the same arguments.
+	void record(const InputFrame& input, float dt) {
+		if (!file) return;
+		
+		uint16_t inputBits = input.pack();
+		uint32_t dtBits = replay::floatBits(dt);
+		frames++;
+		
+		if (havePending && inputBits == pendingInput && dtBits == pendingDt) {
+			pendingRepeats++;
+			return;
+		}
+		
+		flushPending();
+		havePending = true;
+		pendingInput = inputBits;
+		pendingDt = dtBits;
+		pendingRepeats = 0;
+	}
+	
+	// Writes the footer (with the game's final numbers) and closes the file.
+	bool finish(const Game& game) {
+		if (!file) return false;
+		
+		flushPending();
+		
+		int64_t score = game.score, pieces = game.pieces;
+		int32_t lines = game.lines;
+		put(replay::END_MARKER, 1);
+		put(frames, 8);
+		put(score, 8);
+		put(lines, 4);
+		put(pieces, 8);
+		put(replay::checksum(seed, frames, score, lines, pieces), 8);
+		
+		bool ok = flushBuffer();
+		ok = (fclose(file) == 0) && ok;
+		file = nullptr;
+		return ok;
+	}
+
+private:
+	void flushPending() {
+		if (!havePending) return;
+		
+		uint8_t flags = 0;
+		if (pendingInput != lastInput) flags |= replay::INPUT_CHANGED;
+		if (pendingDt != lastDt) flags |= replay::DT_CHANGED;
+		if (pendingRepeats > 0) flags |= replay::REPEATS;
+		
+		put(flags, 1);
+		if (flags & replay::INPUT_CHANGED) put(pendingInput ^ lastInput, 2);
+		if (flags & replay::DT_CHANGED) put(pendingDt, 4);
+		if (flags & replay::REPEATS) putVarint(pendingRepeats);
+		
+		lastInput = pendingInput;
+		lastDt = pendingDt;
+		havePending = false;
+	}
+	
+	bool flushBuffer() {
+		bool ok = fwrite(buffer, 1, used, file) == used;
+		used = 0;
+		return ok;
+	}
+	
+	void putByte(uint8_t byte) {
+		if (used == BUFFER_SIZE) flushBuffer();
+		buffer[used++] = byte;
+	}
+	
+	void putBytes(const uint8_t* bytes, size_t count) {
+		for (size_t i = 0; i < count; i++) putByte(bytes[i]);
+	}
+	
+	// Little-endian, `bytes` long.
+	void put(uint64_t value, int bytes) {
+		for (int i = 0; i < bytes; i++) putByte(value >> (i * 8));
+	}
+	
+	// LEB128: 7 bits at a time, high bit means "more to come".
+	void putVarint(uint64_t value) {
+		while (value >= 0x80) {
+			putByte((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		putByte(value);
+	}
+};
+
+// Reads a replay straight out of a memory-mapped file, one step at a time.
+struct ReplayReader {
+	MappedFile file;
+	const uint8_t* cursor = nullptr;
+	const uint8_t* recordsEnd = nullptr;
+	
+	uint64_t seed = 0;
+	uint64_t pieceSetHash = 0;
+	
+	// From the footer: what the game should end up like.
+	uint64_t frames = 0;
+	int64_t score = 0;
+	int32_t lines = 0;
+	int64_t pieces = 0;
+	
+	// Set if the file ends up being cut short or mangled.
+	bool corrupt = false;
+	
+	uint16_t input = 0;
+	uint32_t dt = 0;
+	uint64_t repeatsLeft = 0;
+	
+	// Maps the file and checks its header and footer.
+	bool open(const char* path) {
+		corrupt = false;
+		if (!file.open(path)) return false;
+		if (file.size < replay::HEADER_SIZE + replay::FOOTER_SIZE) return false;
+		
+		const uint8_t* header = file.data;
+		if (memcmp(header, replay::MAGIC, 4) != 0 || header[4] != replay::VERSION) return false;
+		seed = get(header + 5, 8);
+		pieceSetHash = get(header + 13, 8);
+		
+		const uint8_t* footer = file.data + file.size - replay::FOOTER_SIZE;
+		if (footer[0] != replay::END_MARKER) return false;
+		frames = get(footer + 1, 8);
+		score  = get(footer + 9, 8);
+		lines  = get(footer + 17, 4);
+		pieces = get(footer + 21, 8);
+		if (get(footer + 29, 8) != replay::checksum(seed, frames, score, lines, pieces)) return false;
+		
+		cursor = file.data + replay::HEADER_SIZE;
+		recordsEnd = footer;
+		input = 0; dt = 0; repeatsLeft = 0;
+		return true;
+	}
+	
+	// Gets the next step. Returns false once there aren't any more.
+	bool next(InputFrame& nextInput, float& nextDt) {
+		if (repeatsLeft > 0) {
+			repeatsLeft--;
+		} else {
+			if (cursor >= recordsEnd) return false;
+			
+			uint8_t flags = *cursor++;
+			if (flags & replay::INPUT_CHANGED) {
+				if (recordsEnd - cursor < 2) return fail();
+				input ^= get(cursor, 2);
+				cursor += 2;
+			}
+			if (flags & replay::DT_CHANGED) {
+				if (recordsEnd - cursor < 4) return fail();
+				dt = get(cursor, 4);
+				cursor += 4;
+			}
+			if (flags & replay::REPEATS) {
+				if (!getVarint(repeatsLeft)) return fail();
+			}
+		}
+		
+		nextInput = InputFrame::unpack(input);
+		nextDt = replay::bitsFloat(dt);
+		return true;
+	}
+	
+	// Whether it was recorded with these pieces. (If not, it won't play
+	// back right.)
+	bool isFor(const PieceSet& set) const { return pieceSetHash == set.getHash(); }
+	
+	// Whether a game that's played through `framesPlayed` steps of this
+	// replay ended up where the footer says it should.
+	bool matches(const Game& game, uint64_t framesPlayed) const {
+		return !corrupt && framesPlayed == frames
+			&& replay::checksum(seed, framesPlayed, game.score, game.lines, game.pieces)
+			== replay::checksum(seed, frames, score, lines, pieces);
+	}
+
+private:
+	bool fail() {
+		corrupt = true;
+		return false;
+	}
+	
+	static uint64_t get(const uint8_t* bytes, int count) {
+		uint64_t value = 0;
+		for (int i = 0; i < count; i++) value |= (uint64_t)bytes[i] << (i * 8);
+		return value;
+	}
+	
+	bool getVarint(uint64_t& value) {
+		value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (cursor >= recordsEnd) return false;
+			uint8_t byte = *cursor++;
+			value |= (uint64_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return true;
+		}
+		return false;
+	}
+};
+
+// Plays a replay back as fast as possible, and checks that it ends up
+// where the file says it should.
+struct ReplayCheck {
+	bool readable = false;
+	bool rightPieces = false;
+	bool matches = false;
+	
+	uint64_t frames = 0;
+	int64_t score = 0, expectedScore = 0;
+	int32_t lines = 0, expectedLines = 0;
+};
+
+// (Replays recorded with some other piece set aren't played at all.)
+inline ReplayCheck checkReplay(const char* path, const PieceSet& set = BUILT_IN_PIECE_SET) {
+	ReplayCheck check;
+	
+	ReplayReader reader;
+	if (!reader.open(path)) return check;
+	
+	check.readable = true;
+	check.rightPieces = reader.isFor(set);
+	if (!check.rightPieces) return check;
+	
+	Game game(reader.seed, set);
+	InputFrame input;
+	float dt;
+	while (reader.next(input, dt)) {
+		game.step(input, dt);
+		check.frames++;
+	}
+	
+	check.readable = !reader.corrupt;
+	check.score = game.score;
+	check.lines = game.lines;
+	check.expectedScore = reader.score;
+	check.expectedLines = reader.lines;
+	check.matches = reader.matches(game, check.frames);
+	return check;
+}
@@ -0,0 +1,66 @@
+// Guideline Tetris!!
+// A small, fast, seedable random number generator that gives the same
+// numbers on every platform and compiler.
+
+#pragma once
+
+#include <cstdint>
+
+// xoshiro128** (https://prng.di.unimi.it/), seeded through splitmix64.
+// Only fixed-width unsigned math, so a seed means the same thing everywhere.
+// (Unlike `rand()`, or `std::uniform_int_distribution`.)
+struct Rng {
+	uint32_t state[4];
+	
+	Rng(uint64_t seed = 1) { reseed(seed); }
+	
+	// Spreads a 64-bit seed across the whole state, so even seeds like
+	// 1, 2, 3... give completely unrelated sequences.
+	void reseed(uint64_t seed) {
+		for (int i = 0; i < 4; i += 2) {
+			uint64_t z = (seed += 0x9E3779B97F4A7C15);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+			z ^= z >> 31;
+			state[i]     = (uint32_t)z;
+			state[i + 1] = (uint32_t)(z >> 32);
+		}
+		
+		// The one state xoshiro can't get out of.
+		if (!(state[0] | state[1] | state[2] | state[3])) state[0] = 1;
+	}
+	
+	static uint32_t rotl(uint32_t x, int k) {
+		return (x << k) | (x >> (32 - k));
+	}
+	
+	// Returns 32 random bits.
+	uint32_t next() {
+		uint32_t result = rotl(state[1] * 5, 7) * 9;
+		uint32_t t = state[1] << 9;
+		
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = rotl(state[3], 11);
+		
+		return result;
+	}
+	
+	// Returns a number in [0, n), with every number equally likely.
+	// (Lemire's multiply-and-reject. `next() % n` favours small numbers.)
+	uint32_t below(uint32_t n) {
+		uint64_t m = (uint64_t)next() * n;
+		uint32_t low = (uint32_t)m;
+		if (low < n) {
+			uint32_t threshold = (0u - n) % n;
+			while (low < threshold) {
+				m = (uint64_t)next() * n;
+				low = (uint32_t)m;
+			}
+		}
+		return m >> 32;
+	}
+};
@@ -0,0 +1,217 @@
+// Guideline Tetris!!
+// Rollback netcode (like GGPO) for two-player versus: both games run ahead
+// on guessed input, and quietly redo the last few frames when a guess was
+// wrong.
+
+#pragma once
+
+#include "game.hpp"
+#include "pieceset.hpp"
+#include "timestep.hpp"
+
+#include <cstdint>
+#include <type_traits>
+
+// Both players' games, stepped together one fixed tick ("frame") at a time,
+// sending each other garbage like in versus mode. Each side runs the exact
+// same simulation, with the exact same inputs, so only inputs ever have to
+// go over the network.
+//
+// This side's own input is known right away. The other side's shows up
+// whenever it shows up, so until then it gets predicted: whatever keys
+// were held last time, and no taps (which is right almost every frame).
+// The state at the start of every recent frame gets saved (it's one flat
+// copy; see game.hpp), so when an input arrives that doesn't match what was
+// predicted, it's back to that frame and forward again with the real one.
+//
+// Nothing in here knows about sockets; see netplay.hpp for that.
+struct RollbackSession {
+	// How far ahead of the other side's input this side can run, in frames.
+	// Any more, and it waits.
+	static const int MAX_ROLLBACK = 10;
+	
+	// How many frames of inputs and snapshots are kept around. Inputs stay
+	// until the other side says it's got them, so this is also how far
+	// behind its acknowledgements can get before this side waits.
+	static const int HISTORY = 64;
+	static const int MAX_UNACKED = HISTORY - MAX_ROLLBACK - 2;
+	static_assert((HISTORY & (HISTORY - 1)) == 0, "history size must be a power of two");
+	
+	// How often to check whether this side has gotten ahead of the other.
+	static const int SYNC_INTERVAL = 60;
+	
+	static const uint32_t NO_ROLLBACK = UINT32_MAX;
+	
+	struct State {
+		Game games[2];
+	};
+	static_assert(std::is_trivially_copyable<State>::value, "snapshots are plain copies");
+	
+	State state;
+	
+	// The next frame to simulate. (So, how many have been.)
+	uint32_t frame = 0;
+	
+	int local, remote; // which game is whose
+	
+	// The other side's inputs are known for every frame before this one.
+	uint32_t remoteConfirmed = 0;
+	
+	// And the other side has said it's got ours from before this one.
+	uint32_t localAcked = 0;
+	
+	// The latest the other side has said about itself: its frame, and how
+	// far ahead of us it thought it was.
+	uint32_t remoteFrame = 0;
+	int remoteAdvantage = 0;
+	
+	// The earliest frame that was simulated with a wrong guess, if any.
+	uint32_t rollbackFrom = NO_ROLLBACK;
+	
+	// Stats, for seeing how it's going.
+	long int rollbacks = 0;
+	long int framesResimulated = 0;
+	int maxRollbackFrames = 0;
+	
+	// Both games get the same seeds on both sides: player 0's is `seed`,
+	// player 1's is `seed + 1`.
+	RollbackSession(int localPlayer, uint64_t seed, const PieceSet& set)
+		: local(localPlayer), remote(1 - localPlayer) {
+		state.games[0] = Game(seed, set);
+		state.games[1] = Game(seed + 1, set);
+		for (auto& game : state.games) game.restart();
+	}
+	
+	Game& getLocalGame() { return state.games[local]; }
+	Game& getRemoteGame() { return state.games[remote]; }
+	
+	// Whether this side is allowed to run another frame yet.
+	bool canAdvance() const {
+		return frame < remoteConfirmed + MAX_ROLLBACK && frame - localAcked < MAX_UNACKED;
+	}
+	
+	// Runs one frame, with this side's input for it. First, though, it
+	// redoes anything that turned out to be guessed wrong.
+	// Returns false if it's too far ahead of the other side to run a frame
+	// right now (try again next tick, with the same input).
+	bool advance(const InputFrame& input) {
+		rollBack();
+		if (!canAdvance()) return false;
+		
+		inputs[frame % HISTORY][local] = input.pack();
+		simulate();
+		return true;
+	}
+	
+	// Call once a tick, before `advance`. Returns true if this side should
+	// sit this tick out, to let the other catch up. (Otherwise the one
+	// that's ahead keeps having to predict, and roll back, more than it
+	// needs to.)
+	bool shouldWait() {
+		if (framesToWait > 0) {
+			framesToWait--;
+			return true;
+		}
+		if (frame - lastSync < SYNC_INTERVAL) return false;
+		lastSync = frame;
+		
+		// Both sides see each other late by the same network delay, so the
+		// difference between what each thinks is fair. Split it, since the
+		// other side is catching up at the same time.
+		int ahead = (getLocalAdvantage() - remoteAdvantage) / 2;
+		if (ahead < 1) return false;
+		framesToWait = ahead - 1;
+		return true;
+	}
+	
+	// How far ahead of the other side this one seems to be, in frames.
+	int getLocalAdvantage() const { return (int)(frame - remoteFrame); }
+	
+	// The other side's inputs: `count` of them, from frame `first` on.
+	// (Anything already seen gets skipped, and anything after a gap waits
+	// for the next packet, which always starts from what's acknowledged.)
+	void receiveInputs(uint32_t first, const uint16_t* remoteInputs, int count) {
+		for (int i = 0; i < count; i++) {
+			uint32_t f = first + i;
+			if (f < remoteConfirmed) continue;
+			if (f > remoteConfirmed || f >= frame + HISTORY - MAX_ROLLBACK) break;
+			
+			// If it's already been simulated, the guess had better be right.
+			uint16_t& slot = inputs[f % HISTORY][remote];
+			if (f < frame && slot != remoteInputs[i] && f < rollbackFrom)
+				rollbackFrom = f;
+			slot = remoteInputs[i];
+			remoteConfirmed++;
+		}
+	}
+	
+	// What the other side says about itself (see the members above).
+	void receiveStatus(uint32_t theirFrame, int theirAdvantage, uint32_t theirConfirmed) {
+		if (theirFrame > remoteFrame) {
+			remoteFrame = theirFrame;
+			remoteAdvantage = theirAdvantage;
+		}
+		// (Can't have gotten inputs that haven't been made yet.)
+		if (theirConfirmed > localAcked && theirConfirmed <= frame)
+			localAcked = theirConfirmed;
+	}
+	
+	// This side's input for a frame it's already run. (For sending.)
+	uint16_t getLocalInput(uint32_t f) const {
+		return inputs[f % HISTORY][local];
+	}
+	
+	// Goes back to the first wrongly guessed frame, if there is one, and
+	// runs everything since again with what's known now.
+	void rollBack() {
+		if (rollbackFrom == NO_ROLLBACK) return;
+		
+		uint32_t target = frame;
+		frame = rollbackFrom;
+		rollbackFrom = NO_ROLLBACK;
+		state = snapshots[frame % HISTORY];
+		
+		int redone = target - frame;
+		rollbacks++;
+		framesResimulated += redone;
+		if (redone > maxRollbackFrames) maxRollbackFrames = redone;
+		
+		while (frame < target) simulate();
+	}
+
+private:
+	uint16_t inputs[HISTORY][2] = {};
+	
+	// The state at the start of each frame.
+	State snapshots[HISTORY];
+	
+	uint32_t lastSync = 0;
+	int framesToWait = 0;
+	
+	// Held keys carry on; taps don't.
+	uint16_t predict() const {
+		if (remoteConfirmed == 0) return 0;
+		InputFrame last = InputFrame::unpack(inputs[(remoteConfirmed - 1) % HISTORY][remote]);
+		last.clearTaps();
+		return last.pack();
+	}
+	
+	void simulate() {
+		snapshots[frame % HISTORY] = state;
+		
+		uint16_t* frameInputs = inputs[frame % HISTORY];
+		if (frame >= remoteConfirmed) frameInputs[remote] = predict();
+		
+		for (int p = 0; p < 2; p++)
+			state.games[p].step(InputFrame::unpack(frameInputs[p]), FixedTimestep::TICK_SECONDS);
+		
+		// Garbage goes straight across.
+		Game& a = state.games[0];
+		Game& b = state.games[1];
+		a.garbageQueued += b.garbageToSend;
+		b.garbageQueued += a.garbageToSend;
+		a.garbageToSend = b.garbageToSend = 0;
+		
+		frame++;
+	}
+};
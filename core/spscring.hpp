@@ -0,0 +1,58 @@
+// Guideline Tetris!!
+// A fixed-size queue between exactly one producer thread and one consumer.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// No locks, no allocation: the producer only ever writes `tail`, and the
+// consumer only ever writes `head`. Each side caches the other's index, so
+// most pushes and pops don't even touch the other thread's cache line.
+//
+// CAPACITY has to be a power of two. (Indices just count up forever, and
+// get masked down when indexing into `items`.)
+template<typename T, int CAPACITY>
+class SpscRing {
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+public:
+	// Producer only. Returns false (and drops `item`) if the ring is full.
+	bool push(const T& item) {
+		uint32_t t = tail.load(std::memory_order_relaxed);
+		if (t - producerHead == CAPACITY) {
+			producerHead = head.load(std::memory_order_acquire);
+			if (t - producerHead == CAPACITY) return false;
+		}
+		
+		items[t & (CAPACITY - 1)] = item;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+	
+	// Consumer only. The oldest item, or null if there aren't any.
+	// (It stays valid until the next `pop`.)
+	const T* front() {
+		uint32_t h = head.load(std::memory_order_relaxed);
+		if (h == consumerTail) {
+			consumerTail = tail.load(std::memory_order_acquire);
+			if (h == consumerTail) return nullptr;
+		}
+		return &items[h & (CAPACITY - 1)];
+	}
+	
+	// Consumer only. Throws away the oldest item. (Only after `front`
+	// said there was one!)
+	void pop() {
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	alignas(64) std::atomic<uint32_t> head { 0 };
+	uint32_t consumerTail = 0;
+	
+	alignas(64) std::atomic<uint32_t> tail { 0 };
+	uint32_t producerHead = 0;
+	
+	alignas(64) T items[CAPACITY];
+};
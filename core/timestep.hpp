@@ -0,0 +1,39 @@
+// Guideline Tetris!!
+// Runs the game at a fixed rate, however fast or slow frames come in.
+
+#pragma once
+
+// Frame time goes into an accumulator, and comes back out as whole ticks.
+// Slow frames run several ticks to catch up, fast frames might not run any.
+// Whatever's left over says how far it is between the last tick and the
+// next one, for drawing things in between.
+struct FixedTimestep {
+	static constexpr double TICK_RATE = 120;
+	static constexpr double TICK_SECONDS = 1.0 / TICK_RATE;
+	
+	// If a frame takes longer than this many ticks (a quarter second), the
+	// rest is thrown away, instead of trying to catch up on all of it.
+	// (Like when the window's being dragged around.)
+	static const int MAX_TICKS_PER_FRAME = 30;
+	
+	double accumulator = 0;
+	
+	// Adds a frame's worth of time. Returns how many ticks to run for it.
+	int advance(double frameSeconds) {
+		accumulator += frameSeconds;
+		
+		int ticks = accumulator / TICK_SECONDS;
+		if (ticks > MAX_TICKS_PER_FRAME) {
+			accumulator = 0;
+			return MAX_TICKS_PER_FRAME;
+		}
+		
+		accumulator -= ticks * TICK_SECONDS;
+		return ticks;
+	}
+	
+	// How far the clock is past the last tick, from 0 to 1 (of a tick).
+	float getAlpha() const {
+		return accumulator / TICK_SECONDS;
+	}
+};
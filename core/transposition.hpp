@@ -0,0 +1,148 @@
+// Guideline Tetris!!
+// A fixed-size cache of search results, keyed by Zobrist hash, that any
+// number of threads can read and write at once without locking.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Entries are two 64-bit words: the result, and the key XORed with the
+// result. A read that races with a write can come away with one word of
+// each, but then the key doesn't check out and it's just a miss, so nobody
+// ever needs a lock. (Hyatt and Mann's "lockless transposition table".)
+//
+// Entries come four to a bucket, one cache line each. A key can go in any
+// entry of its bucket; when they're all taken, the one from the oldest
+// search goes first, then whichever was the shallowest search (the
+// cheapest to do again).
+class TranspositionTable {
+public:
+	struct Result {
+		float score = 0;
+		int depth = 0; // how many pieces deep the search went (1 to 255)
+	};
+	
+	static const int BUCKET_ENTRIES = 4;
+	
+	explicit TranspositionTable(size_t megabytes = 16) { resize(megabytes); }
+	
+	TranspositionTable(const TranspositionTable&) = delete;
+	TranspositionTable& operator=(const TranspositionTable&) = delete;
+	
+	// Throws everything out, and takes up about this much memory instead.
+	// (Rounded down to a power of two's worth of buckets.) Not while anybody's
+	// using it.
+	void resize(size_t megabytes) {
+		size_t target = megabytes * 1024 * 1024 / sizeof(Bucket);
+		bucketCount = 1;
+		while (bucketCount * 2 <= target) bucketCount *= 2;
+		
+		buckets.reset(new Bucket[bucketCount]);
+		clear();
+	}
+	
+	// Throws everything out. Not while anybody's using it.
+	void clear() {
+		for (size_t i = 0; i < bucketCount; i++)
+			for (auto& entry : buckets[i].entries) {
+				entry.check.store(0, std::memory_order_relaxed);
+				entry.data.store(0, std::memory_order_relaxed);
+			}
+		age = 0;
+	}
+	
+	// Call before each new search, so results from older ones make way
+	// first. (They're still used if they're there.)
+	void newSearch() { age = (age + 1) & 0xFF; }
+	
+	size_t getSizeBytes() const { return bucketCount * sizeof(Bucket); }
+	size_t getEntryCount() const { return bucketCount * BUCKET_ENTRIES; }
+	
+	// Looks for `key`. Returns true, and fills in `result`, if it's there.
+	bool probe(uint64_t key, Result& result) const {
+		const Bucket& bucket = getBucket(key);
+		for (const auto& entry : bucket.entries) {
+			uint64_t data = entry.data.load(std::memory_order_relaxed);
+			uint64_t check = entry.check.load(std::memory_order_relaxed);
+			if ((check ^ data) != key || data == 0) continue;
+			
+			result = unpack(data);
+			return true;
+		}
+		return false;
+	}
+	
+	// Saves a result, over an older one for the same key if it's at least
+	// as deep, or else over whichever entry in its bucket is worth least.
+	void store(uint64_t key, const Result& result) {
+		Bucket& bucket = getBucket(key);
+		uint64_t data = pack(result);
+		
+		Entry* victim = nullptr;
+		int victimWorth = INT32_MAX;
+		for (auto& entry : bucket.entries) {
+			uint64_t oldData = entry.data.load(std::memory_order_relaxed);
+			uint64_t oldCheck = entry.check.load(std::memory_order_relaxed);
+			
+			if ((oldCheck ^ oldData) == key && oldData != 0) {
+				if (getDepth(oldData) > result.depth) return;
+				victim = &entry;
+				break;
+			}
+			
+			// Empty entries go first, then old ones, then shallow ones.
+			int worth = oldData == 0 ? -1 : getDepth(oldData) + (getAge(oldData) == age ? 256 : 0);
+			if (worth < victimWorth) {
+				victimWorth = worth;
+				victim = &entry;
+			}
+		}
+		
+		victim->check.store(key ^ data, std::memory_order_relaxed);
+		victim->data.store(data, std::memory_order_relaxed);
+	}
+
+private:
+	struct Entry {
+		std::atomic<uint64_t> check { 0 };
+		std::atomic<uint64_t> data { 0 };
+	};
+	
+	struct alignas(64) Bucket {
+		Entry entries[BUCKET_ENTRIES];
+	};
+	static_assert(sizeof(Bucket) == 64, "a bucket should be one cache line");
+	
+	std::unique_ptr<Bucket[]> buckets;
+	size_t bucketCount = 0;
+	int age = 0;
+	
+	Bucket& getBucket(uint64_t key) const {
+		// The low bits pick the bucket; (the whole key still gets checked).
+		return buckets[key & (bucketCount - 1)];
+	}
+	
+	// Score's float bits in the low half, then the depth, then the age.
+	// (A stored result always has a depth, so 0 means empty.)
+	uint64_t pack(const Result& result) const {
+		uint32_t scoreBits;
+		memcpy(&scoreBits, &result.score, sizeof(scoreBits));
+		int depth = result.depth < 1 ? 1 : result.depth > 255 ? 255 : result.depth;
+		return scoreBits | (uint64_t)depth << 32 | (uint64_t)age << 40;
+	}
+	
+	static Result unpack(uint64_t data) {
+		Result result;
+		uint32_t scoreBits = (uint32_t)data;
+		memcpy(&result.score, &scoreBits, sizeof(scoreBits));
+		result.depth = getDepth(data);
+		return result;
+	}
+	
+	static int getDepth(uint64_t data) { return data >> 32 & 0xFF; }
+	static int getAge(uint64_t data) { return data >> 40 & 0xFF; }
+};
@@ -0,0 +1,133 @@
+// Guideline Tetris!!
+// Bare-bones non-blocking UDP sockets (IPv4 only), for netplay.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+#else
+	#include <arpa/inet.h>
+	#include <fcntl.h>
+	#include <netdb.h>
+	#include <netinet/in.h>
+	#include <sys/socket.h>
+	#include <unistd.h>
+#endif
+
+// Where a packet comes from or goes to.
+struct UdpAddress {
+	uint32_t host = 0; // network byte order
+	uint16_t port = 0; // host byte order
+	
+	// Looks up `name` (a host name or a dotted address).
+	bool resolve(const char* name, int port) {
+		addrinfo hints = {}, *found = nullptr;
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_DGRAM;
+		if (getaddrinfo(name, nullptr, &hints, &found) != 0 || !found) return false;
+		
+		host = ((const sockaddr_in*)found->ai_addr)->sin_addr.s_addr;
+		this->port = port;
+		freeaddrinfo(found);
+		return true;
+	}
+	
+	bool operator==(const UdpAddress& other) const { return host == other.host && port == other.port; }
+	bool operator!=(const UdpAddress& other) const { return !(*this == other); }
+};
+
+// Sending never blocks, and receiving just says so when there's nothing
+// there, so both can happen right in the middle of a frame.
+struct UdpSocket {
+	UdpSocket() {}
+	UdpSocket(const UdpSocket&) = delete;
+	UdpSocket& operator=(const UdpSocket&) = delete;
+	~UdpSocket() { close(); }
+	
+	// Listens on `port` (on every interface). 0 picks any free port.
+	bool open(int port) {
+		close();
+	
+	#ifdef _WIN32
+		// (Harmless to do more than once.)
+		WSADATA wsa;
+		if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+	#endif
+		
+		handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (!isOpen()) return false;
+		
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		address.sin_port = htons(port);
+		if (bind(handle, (const sockaddr*)&address, sizeof(address)) != 0) { close(); return false; }
+	
+	#ifdef _WIN32
+		u_long nonBlocking = 1;
+		if (ioctlsocket(handle, FIONBIO, &nonBlocking) != 0) { close(); return false; }
+	#else
+		if (fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) | O_NONBLOCK) != 0) { close(); return false; }
+	#endif
+		
+		return true;
+	}
+	
+	bool isOpen() const { return handle != INVALID; }
+	
+	// Which port it ended up on.
+	int getPort() const {
+		sockaddr_in address = {};
+		socklen_t length = sizeof(address);
+		if (getsockname(handle, (sockaddr*)&address, &length) != 0) return 0;
+		return ntohs(address.sin_port);
+	}
+	
+	bool send(const UdpAddress& to, const void* data, size_t size) {
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = to.host;
+		address.sin_port = htons(to.port);
+		return sendto(handle, (const char*)data, size, 0, (const sockaddr*)&address, sizeof(address)) == (int)size;
+	}
+	
+	// Takes the next packet, if there is one. Returns its size, or -1 if
+	// there wasn't one. (Packets bigger than `capacity` get cut short.)
+	int receive(void* data, size_t capacity, UdpAddress& from) {
+		sockaddr_in address = {};
+		socklen_t length = sizeof(address);
+		int size = recvfrom(handle, (char*)data, capacity, 0, (sockaddr*)&address, &length);
+		if (size < 0) return -1;
+		
+		from.host = address.sin_addr.s_addr;
+		from.port = ntohs(address.sin_port);
+		return size;
+	}
+	
+	void close() {
+		if (!isOpen()) return;
+	#ifdef _WIN32
+		closesocket(handle);
+	#else
+		::close(handle);
+	#endif
+		handle = INVALID;
+	}
+
+private:
+#ifdef _WIN32
+	using Handle = SOCKET;
+	static constexpr Handle INVALID = INVALID_SOCKET;
+#else
+	using Handle = int;
+	static constexpr Handle INVALID = -1;
+#endif
+	Handle handle = INVALID;
+};
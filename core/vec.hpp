@@ -0,0 +1,22 @@
+// Guideline Tetris!!
+// Tiny integer vector, so the game logic doesn't need SFML.
+
+#pragma once
+
+// Works like `sf::Vector2i`, minus everything the game logic doesn't use.
+// (Bonus: unlike SFML's, this one is `constexpr`.)
+struct Vec2i {
+	int x = 0, y = 0;
+	
+	constexpr Vec2i() {}
+	constexpr Vec2i(int x, int y) : x(x), y(y) {}
+	
+	constexpr Vec2i operator+(const Vec2i& o) const { return { x + o.x, y + o.y }; }
+	constexpr Vec2i operator-(const Vec2i& o) const { return { x - o.x, y - o.y }; }
+	
+	constexpr Vec2i& operator+=(const Vec2i& o) { x += o.x; y += o.y; return *this; }
+	constexpr Vec2i& operator-=(const Vec2i& o) { x -= o.x; y -= o.y; return *this; }
+	
+	constexpr bool operator==(const Vec2i& o) const { return x == o.x && y == o.y; }
+	constexpr bool operator!=(const Vec2i& o) const { return !(*this == o); }
+};
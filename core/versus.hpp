@@ -0,0 +1,120 @@
+// Guideline Tetris!!
+// Versus mode: one player against a pile of bots, all sending each other
+// garbage lines.
+
+#pragma once
+
+#include "bot.hpp"
+#include "game.hpp"
+#include "pieceset.hpp"
+#include "rng.hpp"
+#include "worksteal.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Every player's game, one after another in one array. Player 0 is the
+// person at the keyboard, and steps however the window likes (see main.cpp);
+// the bots all step together, spread across a thread pool, one tick at a
+// time. Garbage only moves between games after that, on one thread, so
+// the order games step in never matters.
+struct Versus {
+	static const int MAX_OPPONENTS = 64;
+	
+	// Bots only get to press a key this often, so a person stands a chance.
+	// (Pieces still fall in between.)
+	static constexpr float BOT_ACTION_DELAY = 1.0 / 8.0;
+	
+	// Each player on cache lines of their own, so bots stepping on different
+	// threads don't fight over them.
+	struct alignas(64) Player {
+		Game game;
+		Bot bot;
+		float sinceAction = 0;
+		
+		explicit Player(const Game& game) : game(game) {}
+	};
+	
+	std::vector<Player> players;
+	
+	// Who gets each attack. (Seeded, like everything else.)
+	Rng targetRng;
+	
+	// Game `i` gets seed `seed + i`, so the player's game is the same as it
+	// would've been on its own.
+	Versus(int opponents, uint64_t seed, const PieceSet& set) : targetRng(~seed) {
+		if (opponents < 0) opponents = 0;
+		if (opponents > MAX_OPPONENTS) opponents = MAX_OPPONENTS;
+		
+		players.reserve(opponents + 1);
+		for (int i = 0; i <= opponents; i++)
+			players.emplace_back(Game(seed + i, set));
+	}
+	
+	Game& getPlayer() { return players[0].game; }
+	const Game& getOpponent(int i) const { return players[i + 1].game; }
+	int getOpponentCount() const { return players.size() - 1; }
+	
+	int getOpponentsLeft() const {
+		int left = 0;
+		for (int i = 1; i < (int)players.size(); i++)
+			if (!players[i].game.gameOver) left++;
+		return left;
+	}
+	
+	// Starts every bot on a new game. (For when the player starts one.)
+	void startOpponents() {
+		for (int i = 1; i < (int)players.size(); i++) {
+			Player& player = players[i];
+			player.game.restart();
+			player.bot = Bot();
+			player.sinceAction = 0;
+		}
+	}
+	
+	// Steps every bot's game by `dt`, all at once.
+	void stepOpponents(float dt, WorkStealingPool& pool) {
+		auto step = [this, dt](int index, int) {
+			Player& player = players[index + 1];
+			if (player.game.gameOver) return;
+			
+			InputFrame input;
+			player.sinceAction += dt;
+			if (player.sinceAction >= BOT_ACTION_DELAY) {
+				player.sinceAction -= BOT_ACTION_DELAY;
+				input = player.bot.think(player.game);
+			}
+			player.game.step(input, dt);
+		};
+		pool.run(getOpponentCount(), step);
+	}
+	
+	// Hands out the lines every game has sent since last time, each to
+	// somebody else who's still in. (Lines with nobody to go to are lost.)
+	void exchangeGarbage() {
+		for (int i = 0; i < (int)players.size(); i++) {
+			Game& attacker = players[i].game;
+			if (attacker.garbageToSend == 0) continue;
+			
+			int target = pickTarget(i);
+			if (target >= 0) players[target].game.garbageQueued += attacker.garbageToSend;
+			attacker.garbageToSend = 0;
+		}
+	}
+
+private:
+	// A random game that's still going, other than `attacker`'s. -1 if none.
+	int pickTarget(int attacker) {
+		int alive = 0;
+		for (int i = 0; i < (int)players.size(); i++)
+			if (i != attacker && !players[i].game.gameOver) alive++;
+		if (alive == 0) return -1;
+		
+		int pick = targetRng.below(alive);
+		for (int i = 0; i < (int)players.size(); i++) {
+			if (i == attacker || players[i].game.gameOver) continue;
+			if (pick-- == 0) return i;
+		}
+		return -1;
+	}
+};
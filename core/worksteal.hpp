@@ -0,0 +1,167 @@
+// Guideline Tetris!!
+// A small work-stealing thread pool, for chewing through lots of independent
+// jobs (like whole games) that take wildly different amounts of time.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Each worker owns a slice of the index range and eats it from the front.
+// Once its slice runs dry, it steals the back half of somebody else's.
+// A slice is a single 64-bit atomic (begin in the high half, end in the low
+// half), so taking and stealing are both just a compare-and-swap.
+class WorkStealingPool {
+public:
+	// Zero threads means "one per core".
+	explicit WorkStealingPool(int threads = 0) {
+		if (threads <= 0) threads = std::thread::hardware_concurrency();
+		if (threads <= 0) threads = 1;
+		
+		threadCount = threads;
+		slices.reset(new Slice[threadCount]);
+		
+		// The calling thread is worker 0, so spawn one fewer.
+		for (int i = 1; i < threadCount; i++)
+			workers.emplace_back([this, i]{ workerLoop(i); });
+	}
+	
+	~WorkStealingPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& worker : workers) worker.join();
+	}
+	
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+	
+	int getThreadCount() const { return threadCount; }
+	
+	// Calls `fn(index, worker)` once for every index in [0, count),
+	// spread across all workers. Blocks until every call has returned.
+	// `worker` is in [0, getThreadCount()), handy for per-thread scratch space.
+	template<typename F>
+	void run(int count, F& fn) {
+		if (count <= 0) return;
+		
+		job = { &fn, &callJob<F> };
+		
+		// Hand out even slices to start with.
+		for (int i = 0; i < threadCount; i++) {
+			uint32_t begin = (int64_t)count *  i      / threadCount;
+			uint32_t end   = (int64_t)count * (i + 1) / threadCount;
+			slices[i].range.store(pack(begin, end));
+		}
+		
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			generation++;
+			busy = threadCount - 1;
+		}
+		wake.notify_all();
+		
+		work(0);
+		
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this]{ return busy == 0; });
+	}
+
+private:
+	struct alignas(64) Slice {
+		std::atomic<uint64_t> range { 0 };
+	};
+	
+	struct Job {
+		void* context;
+		void (*call)(void* context, int index, int worker);
+	};
+	
+	template<typename F>
+	static void callJob(void* context, int index, int worker) {
+		(*(F*)context)(index, worker);
+	}
+	
+	static uint64_t pack(uint32_t begin, uint32_t end) {
+		return (uint64_t)begin << 32 | end;
+	}
+	
+	// Takes one index off the front of a worker's own slice.
+	bool takeFront(int worker, int& index) {
+		auto& range = slices[worker].range;
+		uint64_t r = range.load();
+		for (;;) {
+			uint32_t begin = r >> 32, end = (uint32_t)r;
+			if (begin >= end) return false;
+			if (range.compare_exchange_weak(r, pack(begin + 1, end))) {
+				index = begin;
+				return true;
+			}
+		}
+	}
+	
+	// Moves the back half of another worker's slice into this one.
+	// Returns false if there was nothing left to steal anywhere.
+	bool steal(int thief) {
+		for (int k = 1; k < threadCount; k++) {
+			auto& range = slices[(thief + k) % threadCount].range;
+			uint64_t r = range.load();
+			for (;;) {
+				uint32_t begin = r >> 32, end = (uint32_t)r;
+				if (begin >= end) break;
+				
+				uint32_t middle = begin + (end - begin) / 2;
+				if (range.compare_exchange_weak(r, pack(begin, middle))) {
+					slices[thief].range.store(pack(middle, end));
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	
+	void work(int worker) {
+		int index;
+		do {
+			while (takeFront(worker, index))
+				job.call(job.context, index, worker);
+		} while (steal(worker));
+	}
+	
+	void workerLoop(int worker) {
+		uint64_t seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&]{ return stopping || generation != seen; });
+				if (stopping) return;
+				seen = generation;
+			}
+			
+			work(worker);
+			
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busy == 0) done.notify_one();
+		}
+	}
+	
+	int threadCount;
+	std::unique_ptr<Slice[]> slices;
+	std::vector<std::thread> workers;
+	
+	Job job = { nullptr, nullptr };
+	
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	uint64_t generation = 0;
+	int busy = 0;
+	bool stopping = false;
+};
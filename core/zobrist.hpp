@@ -0,0 +1,83 @@
+// Guideline Tetris!!
+// Zobrist hashing: a random 64-bit key for every tile of the board and for
+// every piece in every spot of the queue, so a position's hash is just the
+// keys of what's in it, XORed together.
+
+#pragma once
+
+#include "pieces.hpp"
+
+#include <cstdint>
+
+// XOR undoes itself, so whatever changes a position can update its hash by
+// XORing the keys of what changed in or out, instead of hashing it all
+// again. (Board keeps its own hash up to date like that; see board.hpp.)
+// Only whether tiles are filled counts, not their colors, since that's all
+// the bot ever looks at.
+//
+// The keys are worked out at compile time, from a fixed seed, so a hash
+// means the same thing every run.
+namespace zobrist {
+	const int ROWS = 32;
+	const int COLUMNS = 10;
+	
+	// Queue slot 0 is the piece that's falling; 1 onwards are the pieces
+	// coming after it, in order.
+	const int QUEUE_SLOTS = 32;
+	
+	// Each row's keys come pre-XORed for every combination of five columns,
+	// so a whole row's worth is two lookups, however many tiles it has.
+	const int HALF_COLUMNS = COLUMNS / 2;
+	const int HALF_COMBINATIONS = 1 << HALF_COLUMNS;
+	static_assert(COLUMNS % 2 == 0, "rows get split into two even halves");
+	
+	struct Keys {
+		uint64_t tiles[ROWS][COLUMNS] = {};
+		uint64_t rowHalves[ROWS][2][HALF_COMBINATIONS] = {};
+		uint64_t pieces[QUEUE_SLOTS][MAX_PIECE_COUNT] = {};
+	};
+	
+	// splitmix64, one step.
+	constexpr uint64_t nextKey(uint64_t& state) {
+		uint64_t z = (state += 0x9E3779B97F4A7C15);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+		return z ^ (z >> 31);
+	}
+	
+	constexpr Keys buildKeys() {
+		Keys keys;
+		uint64_t state = 0x5A0B3157;
+		
+		for (int y = 0; y < ROWS; y++)
+			for (int x = 0; x < COLUMNS; x++)
+				keys.tiles[y][x] = nextKey(state);
+		
+		for (int y = 0; y < ROWS; y++)
+			for (int half = 0; half < 2; half++)
+				for (int columns = 0; columns < HALF_COMBINATIONS; columns++)
+					for (int i = 0; i < HALF_COLUMNS; i++)
+						if (columns >> i & 1)
+							keys.rowHalves[y][half][columns] ^= keys.tiles[y][half * HALF_COLUMNS + i];
+		
+		for (int slot = 0; slot < QUEUE_SLOTS; slot++)
+			for (int id = 0; id < MAX_PIECE_COUNT; id++)
+				keys.pieces[slot][id] = nextKey(state);
+		
+		return keys;
+	}
+	
+	constexpr Keys KEYS = buildKeys();
+	
+	// One tile at (x, y) being filled.
+	inline uint64_t tile(int y, int x) { return KEYS.tiles[y][x]; }
+	
+	// Every tile in row y whose column's bit is set in `columns`.
+	inline uint64_t row(int y, uint32_t columns) {
+		return KEYS.rowHalves[y][0][columns & (HALF_COMBINATIONS - 1)]
+		     ^ KEYS.rowHalves[y][1][columns >> HALF_COLUMNS];
+	}
+	
+	// Piece `id`, in a spot in the queue.
+	inline uint64_t piece(int slot, int id) { return KEYS.pieces[slot][id]; }
+}
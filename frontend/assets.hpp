@@ -0,0 +1,96 @@
+// Guideline Tetris!!
+// Where the game's pictures and font come from.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Build with EMBED_ASSETS defined to bake everything into the executable,
+// so it starts up without touching the disk, from wherever. That needs
+// frontend/embedded_assets.hpp, made by tools/embed.cpp (see build.sh).
+#ifdef EMBED_ASSETS
+	#include "embedded_assets.hpp"
+#endif
+
+enum Asset {
+	ASSET_TILES,
+	ASSET_BACKGROUND,
+	ASSET_FRAME,
+	ASSET_FONT,
+	ASSET_COUNT
+};
+
+// Relative to the working directory, or to wherever the executable is.
+const char* const ASSET_PATHS[ASSET_COUNT] = {
+	"images/tiles.png",
+	"images/background.png",
+	"images/frame.png",
+	"images/comic.ttf",
+};
+
+// A file's worth of bytes. Fonts keep reading from theirs, so it has to
+// stick around as long as the font does.
+struct AssetData {
+	const void* data = nullptr;
+	size_t size = 0;
+};
+
+// Reads each asset into memory (or just points at the embedded copy).
+// Different assets can be read on different threads at once.
+class AssetStore {
+public:
+	// `exePath` is argv[0], for finding assets next to the executable.
+	explicit AssetStore(const char* exePath) {
+		std::string path = exePath ? exePath : "";
+		size_t slash = path.find_last_of("/\\");
+		if (slash != std::string::npos) exeDirectory = path.substr(0, slash + 1);
+	}
+	
+	bool read(Asset asset) {
+	#ifdef EMBED_ASSETS
+		static const AssetData EMBEDDED[ASSET_COUNT] = {
+			{ ASSET_TILES_PNG,      ASSET_TILES_PNG_SIZE },
+			{ ASSET_BACKGROUND_PNG, ASSET_BACKGROUND_PNG_SIZE },
+			{ ASSET_FRAME_PNG,      ASSET_FRAME_PNG_SIZE },
+			{ ASSET_COMIC_TTF,      ASSET_COMIC_TTF_SIZE },
+		};
+		data[asset] = EMBEDDED[asset];
+		return true;
+	#else
+		if (!readFile(ASSET_PATHS[asset], files[asset])
+		&&  !readFile((exeDirectory + ASSET_PATHS[asset]).c_str(), files[asset]))
+			return false;
+		
+		data[asset] = { files[asset].data(), files[asset].size() };
+		return true;
+	#endif
+	}
+	
+	// What `read` got. (Empty if it hasn't, or it failed.)
+	AssetData get(Asset asset) const { return data[asset]; }
+
+private:
+	AssetData data[ASSET_COUNT];
+	std::vector<uint8_t> files[ASSET_COUNT];
+	std::string exeDirectory;
+	
+	static bool readFile(const char* path, std::vector<uint8_t>& out) {
+		FILE* file = fopen(path, "rb");
+		if (!file) return false;
+		
+		bool ok = fseek(file, 0, SEEK_END) == 0;
+		long size = ok ? ftell(file) : -1;
+		ok = size > 0 && fseek(file, 0, SEEK_SET) == 0;
+		if (ok) {
+			out.resize(size);
+			ok = fread(out.data(), 1, size, file) == (size_t)size;
+		}
+		
+		fclose(file);
+		return ok;
+	}
+};
@@ -0,0 +1,51 @@
+// Guideline Tetris!!
+// One texture with the tiles, the frame and the HUD digits all in it.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "hud.hpp"
+
+#include <algorithm>
+#include <initializer_list>
+
+// Stacked top to bottom: the frame, the tiles, the digits, then a little
+// white square. (They only ever get drawn with exact, unsmoothed texture
+// coordinates, so nothing bleeds between them.)
+struct TextureAtlas {
+	sf::Texture texture;
+	
+	sf::IntRect frameRect, tilesRect;
+	DigitAtlas digits;
+	
+	// Plain white, for flat colored quads that go in the same draw call as
+	// everything else. (Point all four corners at the middle of it.)
+	sf::IntRect whiteRect;
+	static const int WHITE_SIZE = 2;
+	
+	// Uploads the (already decoded) pictures, and renders the digits
+	// for each character size, styled by `style`.
+	template<typename Style>
+	bool build(const sf::Image& frame, const sf::Image& tiles, const sf::Font& font,
+	           const Style& style, std::initializer_list<unsigned> characterSizes) {
+		sf::Vector2u frameSize = frame.getSize(), tilesSize = tiles.getSize();
+		sf::Vector2u digitsSize = digits.layout(font, characterSizes);
+		
+		unsigned width = std::max({ frameSize.x, tilesSize.x, digitsSize.x, (unsigned)WHITE_SIZE });
+		unsigned height = frameSize.y + tilesSize.y + digitsSize.y + WHITE_SIZE;
+		if (!texture.create(width, height)) return false;
+		
+		frameRect = { 0, 0, (int)frameSize.x, (int)frameSize.y };
+		tilesRect = { 0, (int)frameSize.y, (int)tilesSize.x, (int)tilesSize.y };
+		whiteRect = { 0, (int)(height - WHITE_SIZE), WHITE_SIZE, WHITE_SIZE };
+		texture.update(frame, frameRect.left, frameRect.top);
+		texture.update(tiles, tilesRect.left, tilesRect.top);
+		
+		sf::Image white;
+		white.create(WHITE_SIZE, WHITE_SIZE, sf::Color::White);
+		texture.update(white, whiteRect.left, whiteRect.top);
+		
+		return digits.render(style, texture, { 0, frameSize.y + tilesSize.y });
+	}
+};
@@ -0,0 +1,220 @@
+// Guideline Tetris!!
+// Draws the board, the falling piece (and its ghost) and the next queue
+// in a couple of draw calls, instead of one sprite per tile.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "../core/board.hpp"
+#include "../core/game.hpp"
+#include "../core/piecebag.hpp"
+#include "../core/pieceset.hpp"
+#include "../core/piecetables.hpp"
+
+#include <algorithm>
+
+// Returns screen coordinates of tiles.
+// (Yes, Tetris lives in a +Y-up coordinate space! It's cool)
+inline sf::Vector2f getTilePosition(const Vec2i& v) {
+	return sf::Vector2f(
+		Board::POSITION.first  + v.x * Board::TILE_SIZE,
+		Board::POSITION.second + ((Board::VISIBLE_HEIGHT - 1) * Board::TILE_SIZE) - v.y * Board::TILE_SIZE
+	);
+}
+
+// Garbage doesn't have a tile of its own, so it's a darkened piece tile.
+const int GARBAGE_LOOKS_LIKE = 1;
+const sf::Color GARBAGE_TINT = { 110, 110, 110 };
+
+// Returns a rectangle surrounding a piece.
+// From here, you can easily get the piece's width and height.
+inline sf::IntRect getPieceRect(const PieceShape& shape) {
+	sf::Vector2i topLeft, bottomRight;
+	
+	for (const auto& tile : shape.getTiles(0)) {
+		topLeft.x = std::min(topLeft.x, tile.x);
+		topLeft.y = std::min(topLeft.y, tile.y);
+		bottomRight.x = std::max(bottomRight.x, tile.x + 1);
+		bottomRight.y = std::max(bottomRight.y, tile.y + 1);
+	}
+	
+	return sf::IntRect(topLeft, bottomRight - topLeft);
+}
+
+// tried to center a smaller rect inside a larger rectangle. untested.
+template<typename T>
+sf::Rect<T> centerRectWithin(const sf::Rect<T>& withinThat, const sf::Rect<T>& centerThis) {
+	return sf::Rect<T>(
+		withinThat.left - (centerThis.left / 2) + (withinThat.width  - (centerThis.width  / 2)) / 2,
+		withinThat.top  - (centerThis.top  / 2) + (withinThat.height - (centerThis.height / 2)) / 2,
+		centerThis.width, centerThis.height
+	);
+}
+
+// Every tile on screen is a quad in one big vertex array, drawn with the
+// tile texture in a single call. The board's quads stay put between frames,
+// and only the cells that changed get rewritten.
+struct BoardRenderer {
+	// Where each group of tiles lives in `tileQuads`. (Counted in quads.)
+	// They draw in this order, so the ghost goes under the piece.
+	static const int BOARD_QUADS = Board::HEIGHT * Board::WIDTH;
+	static const int GHOST_QUADS = MAX_PIECE_TILES;
+	static const int PIECE_QUADS = MAX_PIECE_TILES;
+	static const int NEXT_QUADS  = PieceBag::MIN_VISIBLE * MAX_PIECE_TILES;
+	
+	static const int GHOST_FIRST = BOARD_QUADS;
+	static const int PIECE_FIRST = GHOST_FIRST + GHOST_QUADS;
+	static const int NEXT_FIRST  = PIECE_FIRST + PIECE_QUADS;
+	static const int QUAD_COUNT  = NEXT_FIRST + NEXT_QUADS;
+	
+	const sf::Texture* texture;
+	
+	// Where the tiles start in `texture`. (Tiles go left to right, by color.)
+	sf::Vector2f tilesOrigin;
+	
+	sf::VertexArray tileQuads { sf::Quads, QUAD_COUNT * 4 };
+	
+	// The plain white boxes behind the next queue.
+	sf::VertexArray boxQuads { sf::Quads, PieceBag::MIN_VISIBLE * 4 };
+	
+	// The ghost piece is the falling piece, faded out, where it would land.
+	const sf::Color GHOST_COLOR = { 255, 255, 255, 80 };
+	
+	// Which tile each board cell's quad shows right now. (-1: not set up yet)
+	int shown[Board::HEIGHT][Board::WIDTH];
+	
+	// Next queue layout.
+	// (Slightly a disaster, but good enough.)
+	const sf::IntRect NEXT_BOX_SIZE = { 0, 0, 4, 2 };
+	const sf::Vector2f TO_THE_RIGHT_OF_THE_BOARD = {
+		Board::POSITION.first + Board::WIDTH * Board::TILE_SIZE + 24,
+		Board::POSITION.second + 32
+	};
+	
+	BoardRenderer(const sf::Texture& tiles, sf::Vector2f tilesOrigin = { 0, 0 })
+		: texture(&tiles), tilesOrigin(tilesOrigin) {
+		for (auto& row : shown)
+			for (auto& cell : row)
+				cell = -1;
+		
+		for (int i = 0; i < QUAD_COUNT; i++) hideQuad(&tileQuads[i * 4]);
+		for (int i = GHOST_FIRST; i < GHOST_FIRST + GHOST_QUADS; i++)
+			for (int k = 0; k < 4; k++)
+				tileQuads[i * 4 + k].color = GHOST_COLOR;
+		
+		// The boxes never move, so set them up once.
+		for (int i = 0; i < PieceBag::MIN_VISIBLE; i++) {
+			sf::Vector2f topLeft = TO_THE_RIGHT_OF_THE_BOARD + sf::Vector2f({
+				(float)(NEXT_BOX_SIZE.left),
+				(float)(NEXT_BOX_SIZE.top + Board::TILE_SIZE * NEXT_BOX_SIZE.height * i)
+			});
+			sf::Vector2f size = {
+				(float)(Board::TILE_SIZE * NEXT_BOX_SIZE.width),
+				(float)(Board::TILE_SIZE * NEXT_BOX_SIZE.height - 1)
+			};
+			
+			sf::Vertex* quad = &boxQuads[i * 4];
+			quad[0].position = topLeft;
+			quad[1].position = topLeft + sf::Vector2f(size.x, 0);
+			quad[2].position = topLeft + size;
+			quad[3].position = topLeft + sf::Vector2f(0, size.y);
+			for (int k = 0; k < 4; k++) quad[k].color = sf::Color::White;
+		}
+	}
+	
+	// Points a quad at a tile in the texture and puts it on screen.
+	void setQuad(sf::Vertex* quad, sf::Vector2f topLeft, int tile) {
+		const float SIZE = Board::TILE_SIZE;
+		float u = tilesOrigin.x + tile * SIZE;
+		float v = tilesOrigin.y;
+		
+		quad[0].position = topLeft;
+		quad[1].position = topLeft + sf::Vector2f(SIZE, 0);
+		quad[2].position = topLeft + sf::Vector2f(SIZE, SIZE);
+		quad[3].position = topLeft + sf::Vector2f(0, SIZE);
+		
+		quad[0].texCoords = { u,        v        };
+		quad[1].texCoords = { u + SIZE, v        };
+		quad[2].texCoords = { u + SIZE, v + SIZE };
+		quad[3].texCoords = { u,        v + SIZE };
+	}
+	
+	// Squashes a quad down to nothing, so it doesn't draw.
+	static void hideQuad(sf::Vertex* quad) {
+		for (int k = 0; k < 4; k++) quad[k].position = { 0, 0 };
+	}
+	
+	// Brings the vertices up to date with the game.
+	// The falling piece gets drawn `pieceOffset` tiles away from where it
+	// really is (for smoothing it out between steps).
+	void update(const Game& game, sf::Vector2f pieceOffset = { 0, 0 }) {
+		// Board: only touch cells that changed since last time.
+		for (int j = 0; j < Board::HEIGHT; j++) {
+			for (int i = 0; i < Board::WIDTH; i++) {
+				int tile = game.board.board[j][i];
+				if (shown[j][i] == tile) continue;
+				shown[j][i] = tile;
+				
+				sf::Vertex* quad = &tileQuads[(j * Board::WIDTH + i) * 4];
+				if (tile == 0) {
+					hideQuad(quad);
+					continue;
+				}
+				
+				bool garbage = tile == GARBAGE_TILE;
+				setQuad(quad, getTilePosition({ i, j }), garbage ? GARBAGE_LOOKS_LIKE : tile);
+				for (int k = 0; k < 4; k++)
+					quad[k].color = garbage ? GARBAGE_TINT : sf::Color::White;
+			}
+		}
+		
+		// The falling piece, its ghost and the next queue move around all the
+		// time, but there's only a handful of them.
+		for (int i = GHOST_FIRST; i < QUAD_COUNT; i++) hideQuad(&tileQuads[i * 4]);
+		if (game.gameOver) return;
+		
+		// Ghost piece
+		Vec2i ghostPosition = { game.piece.position.x, game.piece.getDropYCoord(game.board) };
+		int quadIndex = GHOST_FIRST;
+		for (const auto& tile : game.piece.getTiles())
+			setQuad(&tileQuads[quadIndex++ * 4], getTilePosition(ghostPosition + tile), game.piece.shape->color);
+		
+		// Current piece
+		sf::Vector2f offset = { pieceOffset.x * Board::TILE_SIZE, pieceOffset.y * -Board::TILE_SIZE };
+		quadIndex = PIECE_FIRST;
+		for (const auto& tile : game.piece.getTiles())
+			setQuad(&tileQuads[quadIndex++ * 4], getTilePosition(game.piece.position + tile) + offset, game.piece.shape->color);
+		
+		// Next queue
+		for (int i = 0; i < PieceBag::MIN_VISIBLE; i++) {
+			const auto& shape = game.pieceSet->getShape(game.bag.peek(i));
+			
+			sf::IntRect pieceRect = getPieceRect(shape);
+			// (i don't think `centerRectWithin` actually works, oops)
+			sf::FloatRect rect = centerRectWithin((sf::FloatRect)NEXT_BOX_SIZE, (sf::FloatRect)pieceRect);
+			rect.left -= 0.5; rect.top += 0.5;
+			
+			// stumble through rectangle math.
+			// oh gosh, this is all for centering the I and O pieces visually.
+			sf::Vector2f center = TO_THE_RIGHT_OF_THE_BOARD + sf::Vector2f({
+				Board::TILE_SIZE * rect.left,
+				Board::TILE_SIZE * (NEXT_BOX_SIZE.height * (i + 1) - rect.top)
+			});
+			
+			quadIndex = NEXT_FIRST + i * MAX_PIECE_TILES;
+			for (const auto& tile : shape.getTiles(0)) {
+				setQuad(&tileQuads[quadIndex++ * 4], center + sf::Vector2f({
+					(float)tile.x * Board::TILE_SIZE,
+					(float)tile.y * -Board::TILE_SIZE
+				}), shape.color);
+			}
+		}
+	}
+	
+	// Draws everything: the next queue's boxes, then all of the tiles.
+	void draw(sf::RenderTarget& target, bool gameOver) const {
+		if (!gameOver) target.draw(boxQuads);
+		target.draw(tileQuads, texture);
+	}
+};
@@ -0,0 +1,184 @@
+// Guideline Tetris!!
+// Score and level numbers that don't re-layout any text when they change.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+
+// Every digit, already outlined, rendered once into a texture at startup.
+// Numbers are then just a row of textured quads pointing into it.
+// (The digits go into somebody else's texture, like the TextureAtlas.)
+struct DigitAtlas {
+	// Room for this many different text sizes.
+	static const int MAX_SIZES = 4;
+	
+	// Space around each digit, so its outline doesn't bleed into the next.
+	static const int PADDING = 6;
+	
+	struct Digits {
+		unsigned characterSize = 0;
+		
+		// Where each digit is in the texture, padding included.
+		sf::FloatRect cells[10];
+		
+		// How far to move along after drawing each digit.
+		float advances[10] = { 0 };
+	};
+	
+	const sf::Texture* texture = nullptr;
+	Digits sizes[MAX_SIZES];
+	int sizeCount = 0;
+	
+	// Lays out cells for the digits in every requested size, one row per
+	// size. Returns how much room they need.
+	sf::Vector2u layout(const sf::Font& font, std::initializer_list<unsigned> characterSizes) {
+		float width = 0, height = 0;
+		sizeCount = 0;
+		for (unsigned characterSize : characterSizes) {
+			if (sizeCount >= MAX_SIZES) break;
+			Digits& digits = sizes[sizeCount++];
+			digits.characterSize = characterSize;
+			
+			float x = 0;
+			float cellHeight = std::ceil(characterSize * 1.5f) + PADDING * 2;
+			for (int d = 0; d < 10; d++) {
+				digits.advances[d] = font.getGlyph('0' + d, characterSize, false).advance;
+				float cellWidth = std::ceil(digits.advances[d]) + PADDING * 2;
+				digits.cells[d] = { x, height, cellWidth, cellHeight };
+				x += cellWidth;
+			}
+			
+			width = std::max(width, x);
+			height += cellHeight;
+		}
+		
+		return sf::Vector2u(std::ceil(width), std::ceil(height));
+	}
+	
+	// Renders the laid out digits, styled by `style` (which gets a
+	// `sf::Text&`, just like the rest of the text in the game), into `into`
+	// with the top left corner at `at`.
+	template<typename Style>
+	bool render(const Style& style, sf::Texture& into, sf::Vector2u at) {
+		sf::Vector2u size;
+		for (int i = 0; i < sizeCount; i++) {
+			const sf::FloatRect& last = sizes[i].cells[9];
+			size.x = std::max(size.x, (unsigned)(last.left + last.width));
+			size.y = std::max(size.y, (unsigned)(last.top + last.height));
+		}
+		
+		sf::RenderTexture canvas;
+		if (!canvas.create(size.x, size.y)) return false;
+		canvas.clear(sf::Color::Transparent);
+		
+		// Colors get premultiplied by alpha here, and alpha just piles up,
+		// so the outline's soft edges survive being drawn a second time.
+		sf::RenderStates premultiply(sf::BlendMode(
+			sf::BlendMode::SrcAlpha, sf::BlendMode::OneMinusSrcAlpha, sf::BlendMode::Add,
+			sf::BlendMode::One,      sf::BlendMode::OneMinusSrcAlpha, sf::BlendMode::Add
+		));
+		
+		sf::Text text;
+		style(text);
+		for (int i = 0; i < sizeCount; i++) {
+			text.setCharacterSize(sizes[i].characterSize);
+			for (int d = 0; d < 10; d++) {
+				char str[2] = { (char)('0' + d), 0 };
+				text.setString(str);
+				text.setPosition(sizes[i].cells[d].left + PADDING, sizes[i].cells[d].top + PADDING);
+				canvas.draw(text, premultiply);
+			}
+		}
+		
+		canvas.display();
+		into.update(canvas.getTexture(), at.x, at.y);
+		texture = &into;
+		
+		// From here on, cells are where the digits ended up.
+		for (int i = 0; i < sizeCount; i++) {
+			for (auto& cell : sizes[i].cells) {
+				cell.left += at.x;
+				cell.top += at.y;
+			}
+		}
+		return true;
+	}
+	
+	const Digits* getDigits(unsigned characterSize) const {
+		for (int i = 0; i < sizeCount; i++)
+			if (sizes[i].characterSize == characterSize)
+				return &sizes[i];
+		return nullptr;
+	}
+	
+	const sf::Texture& getTexture() const { return *texture; }
+};
+
+// A number drawn out of a DigitAtlas.
+// It only gets laid out again when the value actually changes.
+struct HudNumber {
+	static const int MAX_DIGITS = 16;
+	
+	const DigitAtlas* atlas = nullptr;
+	const DigitAtlas::Digits* digits = nullptr;
+	
+	// Where the number starts. This is the same spot `sf::Text` would
+	// draw the first digit at, e.g. from `findCharacterPos`.
+	sf::Vector2f position;
+	
+	// Pads with leading zeroes up to this many digits.
+	int minDigits = 0;
+	
+	long int value = -1;
+	
+	sf::Vertex vertices[MAX_DIGITS * 4];
+	int digitCount = 0;
+	
+	HudNumber() {}
+	HudNumber(const DigitAtlas& atlas, unsigned characterSize, sf::Vector2f position, int minDigits = 0)
+		: atlas(&atlas), digits(atlas.getDigits(characterSize)), position(position), minDigits(minDigits) {}
+	
+	void set(long int newValue) {
+		if (newValue == value || !digits) return;
+		value = newValue;
+		
+		char str[MAX_DIGITS + 1];
+		snprintf(str, sizeof(str), "%0*ld", minDigits, value);
+		
+		const float PADDING = DigitAtlas::PADDING;
+		float x = position.x;
+		digitCount = 0;
+		for (const char* c = str; *c && digitCount < MAX_DIGITS; c++) {
+			if (*c < '0' || *c > '9') continue;
+			int d = *c - '0';
+			const sf::FloatRect& cell = digits->cells[d];
+			
+			sf::Vector2f topLeft = { x - PADDING, position.y - PADDING };
+			sf::Vertex* quad = &vertices[digitCount++ * 4];
+			quad[0].position = topLeft;
+			quad[1].position = topLeft + sf::Vector2f(cell.width, 0);
+			quad[2].position = topLeft + sf::Vector2f(cell.width, cell.height);
+			quad[3].position = topLeft + sf::Vector2f(0, cell.height);
+			quad[0].texCoords = { cell.left,              cell.top               };
+			quad[1].texCoords = { cell.left + cell.width, cell.top               };
+			quad[2].texCoords = { cell.left + cell.width, cell.top + cell.height };
+			quad[3].texCoords = { cell.left,              cell.top + cell.height };
+			
+			x += digits->advances[d];
+		}
+	}
+	
+	void draw(sf::RenderTarget& target) const {
+		if (digitCount == 0) return;
+		
+		// The digits are premultiplied (see DigitAtlas::render).
+		sf::RenderStates states(&atlas->getTexture());
+		states.blendMode = sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha);
+		target.draw(vertices, digitCount * 4, sf::Quads, states);
+	}
+};
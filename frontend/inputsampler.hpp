@@ -0,0 +1,177 @@
+// Guideline Tetris!!
+// Reads the keyboard on its own thread (on Windows), way more often than
+// frames happen.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "../core/game.hpp"
+#include "../core/spscring.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+	#include <mmsystem.h> // timeBeginPeriod (winmm)
+#endif
+
+// The keys the game cares about.
+enum GameKey : uint8_t {
+	KEY_LEFT,
+	KEY_RIGHT,
+	KEY_SOFT_DROP,
+	KEY_ROTATE_CCW,
+	KEY_ROTATE_CW,
+	KEY_HARD_DROP,
+	KEY_RESTART,
+	GAME_KEY_COUNT
+};
+
+const sf::Keyboard::Key GAME_KEY_BINDINGS[GAME_KEY_COUNT] = {
+	sf::Keyboard::Left,
+	sf::Keyboard::Right,
+	sf::Keyboard::Down,
+	sf::Keyboard::Z,
+	sf::Keyboard::X,
+	sf::Keyboard::Up,
+	sf::Keyboard::R,
+};
+
+// A key going down or coming back up, and when. (In `InputSampler::now` time.)
+struct KeyEvent {
+	double time;
+	GameKey key;
+	bool pressed;
+	
+	// Puts the event into the input for the next step.
+	void applyTo(InputFrame& input) const {
+		switch (key) {
+			case KEY_LEFT:
+				input.leftHeld = pressed;
+				if (pressed) input.dx = -1;
+				break;
+			case KEY_RIGHT:
+				input.rightHeld = pressed;
+				if (pressed) input.dx = +1;
+				break;
+			case KEY_SOFT_DROP: input.softDropHeld = pressed; break;
+			case KEY_ROTATE_CCW: if (pressed) input.rotate = -1; break;
+			case KEY_ROTATE_CW:  if (pressed) input.rotate = +1; break;
+			case KEY_HARD_DROP:  if (pressed) input.hardDrop = true; break;
+			case KEY_RESTART:    if (pressed) input.restart = true; break;
+			default: break;
+		}
+	}
+};
+
+// Polls the keyboard about once a millisecond, and queues up every change
+// with the time it was seen. The main thread then works through the queue,
+// so presses and releases land when they happened, not on the next frame.
+//
+// (Sleeps are only as precise as the OS timer. That's about a millisecond
+// on Linux and macOS, but Windows has to be asked for it, while the
+// sampler's running.)
+//
+// That thread only happens on Windows, though. SFML only supports reading
+// the keyboard from the main thread: macOS won't have it any other way, and
+// on X11 it goes through the window's Display connection, which isn't set
+// up for threads (no XInitThreads). Everywhere else, the main thread reads
+// the keyboard once a frame instead, through `poll`, and changes get timed
+// to that.
+class InputSampler {
+public:
+	using Clock = std::chrono::steady_clock;
+	
+	static constexpr std::chrono::microseconds SAMPLE_PERIOD { 1000 };
+	
+	// Whether the window has focus. (The keyboard gets read no matter which
+	// window is in front, so the main thread has to say.)
+	std::atomic<bool> focused { true };
+	
+	InputSampler() : start(Clock::now()) {}
+	~InputSampler() { stop(); }
+	
+	InputSampler(const InputSampler&) = delete;
+	InputSampler& operator=(const InputSampler&) = delete;
+	
+	void run() {
+		if (running) return;
+		running = true;
+	#ifdef _WIN32
+		timeBeginPeriod(1);
+		thread = std::thread([this]{ sampleLoop(); });
+	#endif
+	}
+	
+	void stop() {
+		if (!running) return;
+		running = false;
+	#ifdef _WIN32
+		thread.join();
+		timeEndPeriod(1);
+	#endif
+	}
+	
+	// Main thread only, once a frame. Reads the keyboard, where there's no
+	// sampling thread to do it (see above).
+	void poll() {
+	#ifndef _WIN32
+		if (running) sample();
+	#endif
+	}
+	
+	// Seconds since the sampler was made. Events are timed with this.
+	double now() const {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+	
+	// Main thread only. The oldest event that hasn't been handled yet.
+	const KeyEvent* peek() { return events.front(); }
+	void pop() { events.pop(); }
+
+private:
+	Clock::time_point start;
+	std::thread thread;
+	std::atomic<bool> running { false };
+	
+	SpscRing<KeyEvent, 256> events;
+	
+	// What the last sample saw. (Only whoever's sampling touches it.)
+	bool held[GAME_KEY_COUNT] = { false };
+	
+	// Reads every key once, and queues up whatever changed.
+	void sample() {
+		bool canPress = focused.load(std::memory_order_relaxed);
+		double time = now();
+		
+		for (int k = 0; k < GAME_KEY_COUNT; k++) {
+			// Letting go of the window lets go of the keys, too.
+			bool down = canPress && sf::Keyboard::isKeyPressed(GAME_KEY_BINDINGS[k]);
+			if (down == held[k]) continue;
+			
+			// If the queue's full, the change gets noticed again next time.
+			if (events.push({ time, (GameKey)k, down }))
+				held[k] = down;
+		}
+	}
+	
+	void sampleLoop() {
+		auto next = Clock::now();
+		
+		while (running) {
+			sample();
+			
+			// Don't try to make up for missed samples, just carry on.
+			next += SAMPLE_PERIOD;
+			auto current = Clock::now();
+			if (next < current) next = current;
+			std::this_thread::sleep_until(next);
+		}
+	}
+};
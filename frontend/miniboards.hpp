@@ -0,0 +1,171 @@
+// Guideline Tetris!!
+// Draws lots of little opponent boards (for versus mode) in one draw call.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "boardrenderer.hpp"
+#include "../core/board.hpp"
+#include "../core/game.hpp"
+#include "../core/pieces.hpp"
+#include "../core/versus.hpp"
+
+#include <vector>
+
+// Every board is a grid of flat colored squares, a few pixels each: one
+// quad for the background, one per visible cell, and a few for the falling
+// piece. They're all in one vertex array, textured from the shared atlas
+// (each square just samples the middle of its tile), so any number of
+// boards is still a single draw call. Like BoardRenderer, cells only get
+// rewritten when they change.
+struct MiniBoardRenderer {
+	// Biggest and smallest tiles to try, in pixels.
+	static const int MAX_TILE_SIZE = 6;
+	static const int MIN_TILE_SIZE = 1;
+	
+	// Space between boards.
+	static const int GAP = 4;
+	
+	static const int CELL_QUADS = Board::VISIBLE_HEIGHT * Board::WIDTH;
+	static const int PIECE_FIRST = 1 + CELL_QUADS;
+	static const int QUADS_PER_BOARD = PIECE_FIRST + MAX_PIECE_TILES;
+	
+	const sf::Color BACKGROUND_COLOR = { 30, 30, 40 };
+	const sf::Color LOST_COLOR = { 120, 20, 20 };
+	
+	const sf::Texture* texture;
+	
+	// Where the tiles and the plain white square are in `texture`.
+	sf::Vector2f tilesOrigin, white;
+	
+	int boardCount = 0;
+	int tileSize = 0;
+	
+	// The top left of each board on screen.
+	std::vector<sf::Vector2f> origins;
+	
+	sf::VertexArray quads;
+	
+	// Which tile each cell of each board shows right now (-1: not set up
+	// yet), and whether each board is showing that it's lost. (Boards that
+	// haven't played yet don't count as lost.)
+	std::vector<int> shown;
+	std::vector<bool> shownLost;
+	
+	// Fits `count` boards into `area`, in a grid, as big as they'll go.
+	// (All the allocating happens here, up front.)
+	MiniBoardRenderer(const sf::Texture& texture, sf::Vector2f tilesOrigin, sf::Vector2f white,
+	                  int count, sf::FloatRect area)
+		: texture(&texture), tilesOrigin(tilesOrigin), white(white), boardCount(count),
+		  quads(sf::Quads, count * QUADS_PER_BOARD * 4), shown(count * CELL_QUADS, -1), shownLost(count, false) {
+		int columns = 1;
+		for (tileSize = MAX_TILE_SIZE; tileSize > MIN_TILE_SIZE; tileSize--) {
+			columns = (int)area.width / (Board::WIDTH * tileSize + GAP);
+			int rows = (int)area.height / (Board::VISIBLE_HEIGHT * tileSize + GAP);
+			if (columns * rows >= count) break;
+		}
+		if (columns < 1) columns = 1;
+		
+		float width = Board::WIDTH * tileSize, height = Board::VISIBLE_HEIGHT * tileSize;
+		for (int b = 0; b < count; b++) {
+			sf::Vector2f origin = {
+				area.left + (b % columns) * (width + GAP),
+				area.top + (b / columns) * (height + GAP)
+			};
+			origins.push_back(origin);
+			
+			// The backgrounds never move, just change color.
+			sf::Vertex* quad = &quads[b * QUADS_PER_BOARD * 4];
+			setQuad(quad, origin - sf::Vector2f(1, 1), { width + 2, height + 2 }, white);
+			setColor(quad, BACKGROUND_COLOR);
+			
+			for (int i = 1; i < QUADS_PER_BOARD; i++)
+				BoardRenderer::hideQuad(&quad[i * 4]);
+		}
+	}
+	
+	// Brings every board's vertices up to date with the opponents' games.
+	void update(const Versus& versus) {
+		for (int b = 0; b < boardCount; b++)
+			update(b, versus.getOpponent(b));
+	}
+	
+	// Brings one board's vertices up to date with a game.
+	void update(int b, const Game& game) {
+		sf::Vertex* boardQuads = &quads[b * QUADS_PER_BOARD * 4];
+		
+		bool lost = game.gameOver && game.pieces > 0;
+		if (shownLost[b] != lost) {
+			shownLost[b] = lost;
+			setColor(boardQuads, lost ? LOST_COLOR : BACKGROUND_COLOR);
+		}
+		
+		int* cells = &shown[b * CELL_QUADS];
+		for (int j = 0; j < Board::VISIBLE_HEIGHT; j++) {
+			for (int i = 0; i < Board::WIDTH; i++) {
+				int tile = game.board.board[j][i];
+				int& cell = cells[j * Board::WIDTH + i];
+				if (cell == tile) continue;
+				cell = tile;
+				
+				sf::Vertex* quad = &boardQuads[(1 + j * Board::WIDTH + i) * 4];
+				if (tile == 0) BoardRenderer::hideQuad(quad);
+				else setTile(quad, getCellPosition(b, { i, j }), tile);
+			}
+		}
+		
+		// The falling piece. (It goes unseen above the top, like on the
+		// real board.)
+		for (int k = 0; k < MAX_PIECE_TILES; k++)
+			BoardRenderer::hideQuad(&boardQuads[(PIECE_FIRST + k) * 4]);
+		if (game.gameOver) return;
+		
+		int k = 0;
+		for (const auto& tile : game.piece.getTiles()) {
+			Vec2i v = game.piece.position + tile;
+			if (v.y < Board::VISIBLE_HEIGHT)
+				setTile(&boardQuads[(PIECE_FIRST + k) * 4], getCellPosition(b, v), game.piece.shape->color);
+			k++;
+		}
+	}
+	
+	void draw(sf::RenderTarget& target) const {
+		target.draw(quads, texture);
+	}
+
+private:
+	sf::Vector2f getCellPosition(int board, const Vec2i& v) const {
+		return origins[board] + sf::Vector2f(
+			v.x * tileSize,
+			(Board::VISIBLE_HEIGHT - 1 - v.y) * tileSize
+		);
+	}
+	
+	// A square of one tile's color. (Tiles are too small here to show
+	// anything but that.)
+	void setTile(sf::Vertex* quad, sf::Vector2f topLeft, int tile) {
+		bool garbage = tile == GARBAGE_TILE;
+		if (garbage) tile = GARBAGE_LOOKS_LIKE;
+		
+		sf::Vector2f middle = tilesOrigin + sf::Vector2f(
+			tile * Board::TILE_SIZE + Board::TILE_SIZE / 2,
+			Board::TILE_SIZE / 2
+		);
+		setQuad(quad, topLeft, { (float)tileSize, (float)tileSize }, middle);
+		setColor(quad, garbage ? GARBAGE_TINT : sf::Color::White);
+	}
+	
+	// A rectangle where every corner samples the same spot of the texture.
+	static void setQuad(sf::Vertex* quad, sf::Vector2f topLeft, sf::Vector2f size, sf::Vector2f texel) {
+		quad[0].position = topLeft;
+		quad[1].position = topLeft + sf::Vector2f(size.x, 0);
+		quad[2].position = topLeft + size;
+		quad[3].position = topLeft + sf::Vector2f(0, size.y);
+		for (int k = 0; k < 4; k++) quad[k].texCoords = texel;
+	}
+	
+	static void setColor(sf::Vertex* quad, sf::Color color) {
+		for (int k = 0; k < 4; k++) quad[k].color = color;
+	}
+};
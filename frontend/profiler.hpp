@@ -0,0 +1,221 @@
+// Guideline Tetris!!
+// Times each part of a frame, to find out where the time goes when frames drop.
+
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+// Keeps the last WINDOW frames' worth of timings for each phase of the frame,
+// plus a histogram of them for percentiles. Everything's a fixed-size array,
+// so nothing gets allocated after construction.
+//
+// While it's not `enabled`, timing a phase is just one check of a bool.
+struct FrameProfiler {
+	enum Phase {
+		EVENTS,
+		UPDATE,
+		DRAW_BOARD,
+		DRAW_TEXT,
+		DISPLAY,
+		PHASE_COUNT
+	};
+	
+	static constexpr const char* PHASE_NAMES[PHASE_COUNT] = {
+		"events", "update", "board", "text", "display"
+	};
+	
+	// How many frames the stats cover.
+	static const int WINDOW = 256;
+	
+	// Histogram buckets are log-scaled: BUCKETS_PER_DOUBLING of them per
+	// doubling of time, starting at 1 microsecond. (So up to ~65 ms.)
+	static const int BUCKETS_PER_DOUBLING = 8;
+	static const int BUCKETS = 16 * BUCKETS_PER_DOUBLING;
+	
+	struct Stats {
+		float min = 0, avg = 0, p99 = 0; // microseconds
+	};
+	
+	bool enabled = false;
+	
+	// Where to write a line per frame, if anywhere.
+	FILE* csv = nullptr;
+	long int frameNumber = 0;
+	
+	FrameProfiler() {}
+	FrameProfiler(const FrameProfiler&) = delete;
+	FrameProfiler& operator=(const FrameProfiler&) = delete;
+	~FrameProfiler() { if (csv) fclose(csv); }
+	
+	bool openCsv(const char* path) {
+		csv = fopen(path, "w");
+		if (!csv) return false;
+		
+		fprintf(csv, "frame");
+		for (int p = 0; p < PHASE_COUNT; p++) fprintf(csv, ",%s_us", PHASE_NAMES[p]);
+		fprintf(csv, ",total_us\n");
+		return true;
+	}
+	
+	// Adds time to a phase of the current frame.
+	void record(Phase phase, float microseconds) {
+		current[phase] += microseconds;
+	}
+	
+	// Files away the current frame's timings, and starts on the next one.
+	void endFrame() {
+		if (!enabled) return;
+		
+		float total = 0;
+		for (int p = 0; p < PHASE_COUNT; p++) {
+			History& history = histories[p];
+			
+			// Push out the oldest sample, if the window's full.
+			if (sampleCount == WINDOW) {
+				history.sum -= history.samples[next];
+				history.counts[history.buckets[next]]--;
+			}
+			
+			float sample = current[p];
+			int bucket = getBucket(sample);
+			history.samples[next] = sample;
+			history.buckets[next] = bucket;
+			history.counts[bucket]++;
+			history.sum += sample;
+			
+			total += sample;
+		}
+		
+		if (csv) {
+			fprintf(csv, "%ld", frameNumber);
+			for (int p = 0; p < PHASE_COUNT; p++) fprintf(csv, ",%.1f", current[p]);
+			fprintf(csv, ",%.1f\n", total);
+		}
+		
+		next = (next + 1) % WINDOW;
+		if (sampleCount < WINDOW) sampleCount++;
+		frameNumber++;
+		
+		for (auto& time : current) time = 0;
+	}
+	
+	Stats getStats(Phase phase) const {
+		Stats stats;
+		if (sampleCount == 0) return stats;
+		
+		const History& history = histories[phase];
+		stats.min = history.samples[0];
+		for (int i = 0; i < sampleCount; i++)
+			if (history.samples[i] < stats.min)
+				stats.min = history.samples[i];
+		stats.avg = history.sum / sampleCount;
+		
+		// The top of the bucket the 99th percentile falls into.
+		int rank = sampleCount - sampleCount / 100;
+		int seen = 0;
+		for (int b = 0; b < BUCKETS; b++) {
+			seen += history.counts[b];
+			if (seen >= rank) {
+				stats.p99 = std::exp2((float)(b + 1) / BUCKETS_PER_DOUBLING);
+				break;
+			}
+		}
+		
+		return stats;
+	}
+
+private:
+	struct History {
+		float samples[WINDOW] = { 0 };
+		uint8_t buckets[WINDOW] = { 0 };
+		uint16_t counts[BUCKETS] = { 0 };
+		double sum = 0;
+	};
+	static_assert(BUCKETS <= 256, "buckets are stored as bytes");
+	
+	History histories[PHASE_COUNT];
+	float current[PHASE_COUNT] = { 0 };
+	int next = 0, sampleCount = 0;
+	
+	static int getBucket(float microseconds) {
+		if (microseconds <= 1) return 0;
+		int bucket = std::log2(microseconds) * BUCKETS_PER_DOUBLING;
+		return bucket < BUCKETS ? bucket : BUCKETS - 1;
+	}
+};
+
+// Times from construction to the end of the scope, into a phase.
+struct ProfileScope {
+	using Clock = std::chrono::steady_clock;
+	
+	FrameProfiler& profiler;
+	FrameProfiler::Phase phase;
+	Clock::time_point start;
+	
+	ProfileScope(FrameProfiler& profiler, FrameProfiler::Phase phase)
+		: profiler(profiler), phase(phase) {
+		if (profiler.enabled) start = Clock::now();
+	}
+	
+	~ProfileScope() {
+		if (!profiler.enabled) return;
+		std::chrono::duration<float, std::micro> elapsed = Clock::now() - start;
+		profiler.record(phase, elapsed.count());
+	}
+};
+
+// A little table of the profiler's stats, drawn over the top of the window.
+// The text only gets rebuilt a couple of times a second, so it's readable
+// (and so it doesn't cost much itself).
+struct ProfilerOverlay {
+	static constexpr float REFRESH_SECONDS = 0.5;
+	
+	bool visible = false;
+	
+	sf::RectangleShape background;
+	sf::Text text;
+	float sinceRefresh = REFRESH_SECONDS;
+	
+	template<typename Style>
+	ProfilerOverlay(const Style& style, sf::Vector2f position) {
+		style(text);
+		text.setCharacterSize(11);
+		text.setOutlineThickness(1.0);
+		text.setLineSpacing(1.0);
+		text.setPosition(position + sf::Vector2f(4, 2));
+		
+		background.setPosition(position);
+		background.setFillColor(sf::Color(0, 0, 0, 160));
+	}
+	
+	void update(const FrameProfiler& profiler, float dt) {
+		if (!visible) return;
+		
+		sinceRefresh += dt;
+		if (sinceRefresh < REFRESH_SECONDS) return;
+		sinceRefresh = 0;
+		
+		char buffer[512];
+		int length = snprintf(buffer, sizeof(buffer), "%-8s %7s %7s %7s\n", "(us)", "min", "avg", "p99");
+		for (int p = 0; p < FrameProfiler::PHASE_COUNT; p++) {
+			auto stats = profiler.getStats((FrameProfiler::Phase)p);
+			length += snprintf(buffer + length, sizeof(buffer) - length, "%-8s %7.0f %7.0f %7.0f\n",
+				FrameProfiler::PHASE_NAMES[p], stats.min, stats.avg, stats.p99);
+		}
+		
+		text.setString(buffer);
+		sf::FloatRect bounds = text.getLocalBounds();
+		background.setSize({ bounds.left + bounds.width + 8, bounds.top + bounds.height + 6 });
+	}
+	
+	void draw(sf::RenderTarget& target) const {
+		if (!visible) return;
+		target.draw(background);
+		target.draw(text);
+	}
+};
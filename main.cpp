@@ -13,481 +13,245 @@
 
 #include <SFML/Graphics.hpp>
 
-#include <vector>
-#include <deque>
-#include <array>
+#include "core/alloccount.hpp"
+#include "core/bot.hpp"
+#include "core/game.hpp"
+#include "core/netplay.hpp"
+#include "core/replay.hpp"
+#include "core/rollback.hpp"
+#include "core/timestep.hpp"
+#include "core/versus.hpp"
+#include "core/worksteal.hpp"
+#include "frontend/assets.hpp"
+#include "frontend/atlas.hpp"
+#include "frontend/boardrenderer.hpp"
+#include "frontend/hud.hpp"
+#include "frontend/inputsampler.hpp"
+#include "frontend/miniboards.hpp"
+#include "frontend/profiler.hpp"
 
-// TODO: switch RNG to modern C++
+#include <future>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
-struct Board {
-	const static int WIDTH  = 10;
-	const static int HEIGHT = 32;
-	
-	// The Tetris Guidelines say your board needs to have space beyond the top,
-	// but still look like it's 20 tiles tall. It's a neat mechanic! If you try
-	// hard enough, you can roll pieces around up to the 24th row and save
-	// yourself from game overs!
-	const static int VISIBLE_HEIGHT = 20;
-	
-	const static int TILE_SIZE = 18;
-	
-	// The board's position on the screen.
-	static constexpr std::pair<int, int> POSITION = { 28, 31 };
-	
-	// At the start of the game, the board is filled with empty tiles.
-	int board[HEIGHT][WIDTH] = { 0 };
-	
-	// Clears board of all tiles.
-	void clear() {
-		for (int j = 0; j < HEIGHT; j++)
-			for (int i = 0; i < WIDTH; i++)
-				board[j][i] = 0;
-	}
-	
-	// Removes all lines that are filled with non-zero tiles.
-	// Returns how many lines were cleared.
-	int removeFilledLines() {
-		int linesCleared = 0;
-		
-		for (int y = 0; y < HEIGHT; y++) {
-			while (isLineFilled(y)) {
-				removeLine(y);
-				linesCleared++;
-			}
+int main(int argc, char** argv) {
+	// Command line:
+	//   --record file   saves everything you play to `file`
+	//   --replay file   plays `file` back in real time (add --fast to go as
+	//                   fast as possible), then checks it ended up right
+	//   --pieces file   plays with the pieces from `file` (core/pieceset.hpp)
+	//                   (replays only play back with the pieces they were
+	//                   recorded with, so --replay needs the same --pieces)
+	//   --uncapped      draws as many frames as it can, instead of waiting
+	//                   for vsync (the game still steps at the same rate)
+	//   --profile       starts with the frame profiler showing (F3 toggles it)
+	//   --profile-csv file
+	//                   writes how long each part of every frame took to `file`
+	//   --selfplay n    lets the bot play `n` games, without a window, and quits
+	//                   (this is what tools/pgo.sh trains the game on)
+	//   --versus n      plays against `n` bots (up to 64), sending garbage
+	//                   lines back and forth (core/versus.hpp)
+	//   --host port     waits on `port` for somebody to --join, then plays
+	//                   them, sending garbage back and forth (core/rollback.hpp)
+	//   --join address port
+	//                   plays whoever's --hosting at `address`
+	//   --lag ms, --loss percent
+	//                   makes netplay's network worse on purpose, for trying
+	//                   it out on one computer
+	const char* recordPath = nullptr;
+	const char* replayPath = nullptr;
+	const char* profilePath = nullptr;
+	const char* piecesPath = nullptr;
+	bool replayFast = false;
+	bool uncapped = false;
+	bool showProfiler = false;
+	int selfPlayGames = 0;
+	int opponents = 0;
+	int hostPort = 0;
+	const char* joinAddress = nullptr;
+	int joinPort = 0;
+	double fakeLag = 0;
+	float fakeLoss = 0;
+	for (int i = 1; i < argc; i++) {
+		if      (!strcmp(argv[i], "--record") && i + 1 < argc) recordPath = argv[++i];
+		else if (!strcmp(argv[i], "--replay") && i + 1 < argc) replayPath = argv[++i];
+		else if (!strcmp(argv[i], "--fast")) replayFast = true;
+		else if (!strcmp(argv[i], "--pieces") && i + 1 < argc) piecesPath = argv[++i];
+		else if (!strcmp(argv[i], "--uncapped")) uncapped = true;
+		else if (!strcmp(argv[i], "--profile")) showProfiler = true;
+		else if (!strcmp(argv[i], "--profile-csv") && i + 1 < argc) profilePath = argv[++i];
+		else if (!strcmp(argv[i], "--selfplay") && i + 1 < argc) selfPlayGames = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--versus") && i + 1 < argc) opponents = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--host") && i + 1 < argc) hostPort = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--join") && i + 2 < argc) {
+			joinAddress = argv[++i];
+			joinPort = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--lag") && i + 1 < argc) fakeLag = atof(argv[++i]) / 1000;
+		else if (!strcmp(argv[i], "--loss") && i + 1 < argc) fakeLoss = atof(argv[++i]) / 100;
+		else {
+			printf("usage: %s [--record file] [--replay file [--fast]] [--pieces file] [--uncapped] [--profile] [--profile-csv file] [--selfplay n] [--versus n] [--host port | --join address port [--lag ms] [--loss percent]]\n", argv[0]);
+			return EXIT_FAILURE;
 		}
-		
-		return linesCleared;
-	}
-	
-	// Checks if a line of the board is filled.
-	bool isLineFilled(int y) const {
-		if (y < 0) return true;
-		if (y >= HEIGHT) return false;
-		
-		for (int i = 0; i < WIDTH; i++)
-			if (board[y][i] == 0)
-				return false;
-		
-		return true;
-	}
-	
-	// Removes a line from the board, bringing lines above it down too.
-	void removeLine(int y) {
-		if (y < 0 || y >= HEIGHT) return;
-		
-		// Shift lines above this line downwards.
-		for (int j = y + 1; j < HEIGHT; j++)
-			for (int i = 0; i < WIDTH; i++)
-				board[j - 1][i] = board[j][i];
-		
-		// Clear topmost line
-		// (did you know? some official tetris games screw this up!)
-		// https://youtu.be/9X2AYnr2XaQ?t=61 (look at minimap of left board)
-		for (int i = 0; i < WIDTH; i++)
-			board[HEIGHT - 1][i] = 0;
-	}
-	
-	// Returns screen coordinates of tiles.
-	// (Yes, Tetris lives in a +Y-up coordinate space! It's cool)
-	static sf::Vector2f getTilePosition(const sf::Vector2i& v) {
-		return sf::Vector2f(
-			POSITION.first  + v.x * TILE_SIZE,
-			POSITION.second + ((VISIBLE_HEIGHT - 1) * TILE_SIZE) - v.y * TILE_SIZE
-		);
 	}
 	
-	// Checks if a position is on the board.
-	bool isOnBoard(const sf::Vector2i& v) const {
-		return v.x >= 0 && v.x < WIDTH && v.y >= 0 && v.y < HEIGHT;
+	// Replays only have the one player's keys in them, so they can't
+	// reproduce the garbage.
+	bool netplaying = hostPort > 0 || joinAddress;
+	if ((opponents > 0 || netplaying) && (recordPath || replayPath)) {
+		printf("versus games can't be recorded or replayed\n");
+		return EXIT_FAILURE;
 	}
-	
-	// Returns the bounds-checked tile at the supplied position.
-	int getTile(const sf::Vector2i& v) const {
-		if (isOnBoard(v)) return board[v.y][v.x];
-		return 1;
+	if (netplaying && (opponents > 0 || (hostPort > 0 && joinAddress))) {
+		printf("pick one of --versus, --host or --join\n");
+		return EXIT_FAILURE;
 	}
+	if (opponents < 0) opponents = 0;
+	if (opponents > Versus::MAX_OPPONENTS) opponents = Versus::MAX_OPPONENTS;
 	
-	// Sets the tile at the specified position, only if the position is valid.
-	void setTile(const sf::Vector2i& v, int color) {
-		if (isOnBoard(v)) board[v.y][v.x] = color;
+	PieceSet pieceSet = BUILT_IN_PIECE_SET;
+	char pieceError[256];
+	if (piecesPath && !pieceSet.load(piecesPath, pieceError, sizeof(pieceError))) {
+		printf("couldn't load pieces: %s\n", pieceError);
+		return EXIT_FAILURE;
 	}
-};
-
-// fun type alias
-using PieceRotation = std::array<std::vector<std::pair<int, int>>, 4>;
-
-// Tables from https://harddrop.com/wiki/SRS#How_Guideline_SRS_Really_Works
-const PieceRotation PIECE_OFFSETS_I = { {
-	{ { 0, 0}, {-1, 0}, {+2, 0}, {-1, 0}, {+2, 0} }, //   0 deg
-	{ {-1, 0}, { 0, 0}, { 0, 0}, { 0,+1}, { 0,-2} }, //  90 deg
-	{ {-1,+1}, {+1,+1}, {-2,+1}, {+1, 0}, {-2, 0} }, // 180 deg
-	{ { 0,+1}, { 0,+1}, { 0,+1}, { 0,-1}, { 0,+2} }  // 270 deg
-} };
-const PieceRotation PIECE_OFFSETS_JLSTZ { {
-	{ { 0, 0}, { 0, 0}, { 0, 0}, { 0, 0}, { 0, 0} }, //   0 deg
-	{ { 0, 0}, {+1, 0}, {+1,-1}, { 0,+2}, {+1,+2} }, //  90 deg
-	{ { 0, 0}, { 0, 0}, { 0, 0}, { 0, 0}, { 0, 0} }, // 180 deg
-	{ { 0, 0}, {-1, 0}, {-1,-1}, { 0,+2}, {-1,+2} }  // 270 deg
-} };
-const PieceRotation PIECE_OFFSETS_O = { {
-	{ { 0, 0}, }, //   0 deg
-	{ { 0,-1}, }, //  90 deg
-	{ {-1,-1}, }, // 180 deg
-	{ {-1, 0}, }  // 270 deg
-} };
-
-// A piece consists of three things:
-struct PieceDefinition {
-	// ...a list of tiles (where {0, 0} is the center).
-	std::vector<std::pair<int, int>> tiles;
-	
-	// ...a list of "nudges" to try, in order, to make piece rotation easier
-	const PieceRotation* rotations;
 	
-	// ...a tile "color" (pretty much just an index into `images/tiles.png`)
-	int color;
-	
-	// Returns a rectangle surrounding a piece.
-	// From here, you can easily get the piece's width and height.
-	sf::IntRect getPieceRect() const {
-		sf::Vector2i topLeft, bottomRight;
-		
-		for (const auto& tile : tiles) {
-			topLeft.x = std::min(topLeft.x, tile.first );
-			topLeft.y = std::min(topLeft.y, tile.second);
-			bottomRight.x = std::max(bottomRight.x, tile.first  + 1);
-			bottomRight.y = std::max(bottomRight.y, tile.second + 1);
+	if (selfPlayGames > 0) {
+		// Same steps as a real game, just with the bot on the keys.
+		// Seeded 1, 2, 3..., so it's the same every time.
+		long int totalScore = 0, totalPieces = 0;
+		for (int i = 0; i < selfPlayGames; i++) {
+			Game game(i + 1, pieceSet);
+			Bot bot;
+			
+			InputFrame start;
+			start.restart = true;
+			game.step(start, FixedTimestep::TICK_SECONDS);
+			while (!game.gameOver && game.pieces < 2000)
+				game.step(bot.think(game), FixedTimestep::TICK_SECONDS);
+			
+			totalScore += game.score;
+			totalPieces += game.pieces;
 		}
-		
-		return sf::IntRect(topLeft, bottomRight - topLeft);
+		printf("%d games: mean score %.1f, %ld pieces\n", selfPlayGames,
+			(double)totalScore / selfPlayGames, totalPieces);
+		return EXIT_SUCCESS;
 	}
 	
-	// Returns the length of the nudge list.
-	int getOffsetCheckLength(int prevRotation, int nextRotation) const {
-		return std::min(
-			rotations->operator[](prevRotation).size(),
-			rotations->operator[](nextRotation).size()
-		);
-	}
-	
-	// Computes an actual nudge direction, because SRS is bizarre.
-	sf::Vector2i getOffset(int prevRotation, int nextRotation, int check) const {
-		auto prevOffset = rotations->operator[](prevRotation)[check];
-		auto nextOffset = rotations->operator[](nextRotation)[check];
-		
-		return {
-			prevOffset.first - nextOffset.first,
-			prevOffset.second - nextOffset.second
-		};
-	}
-};
-
-// List of pieces.
-// SCOPE: wouldn't it be cool to define pieces at run time?
-const std::vector<PieceDefinition> PIECE_DEFINITIONS = {
-	// Standard Tetrominos
-	{ { {0, 0}, {-1, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_I,     5 }, // I
-	{ { {0, 0}, {-1,+1}, {-1, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 7 }, // J
-	{ { {0, 0}, {+1,+1}, {-1, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 6 }, // L
-	{ { {0, 0}, { 0,+1}, {+1,+1}, {+1, 0} }, &PIECE_OFFSETS_O,     4 }, // O (non-standard)
-	{ { {0, 0}, { 0,+1}, {+1,+1}, {-1, 0} }, &PIECE_OFFSETS_JLSTZ, 3 }, // S
-	{ { {0, 0}, { 0,+1}, {-1, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 1 }, // T
-	{ { {0, 0}, {-1,+1}, { 0,+1}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 2 }, // Z
-	
-	// Funny Pentominos
-	// (I made up some of the names for these, they're very non-standard)
-	{ { {-2, 0}, {-1, 0}, { 0, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_JLSTZ, 5 }, // It
-	{ { { 0,+1}, { 0, 0}, {-1,-1}, { 0,-1}, {+1,-1} }, &PIECE_OFFSETS_JLSTZ, 1 }, // Tt
-	{ { {-1,+1}, {+1,+1}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 4 }, // U
-	{ { {-1,+1}, {-1, 0}, {-1,-1}, { 0,-1}, {+1,-1} }, &PIECE_OFFSETS_JLSTZ, 6 }, // V
-	{ { {-1,+1}, {-1, 0}, { 0, 0}, { 0,-1}, {+1,-1} }, &PIECE_OFFSETS_JLSTZ, 2 }, // W
-	{ { { 0,+1}, {-1, 0}, { 0, 0}, {+1, 0}, { 0,-1} }, &PIECE_OFFSETS_JLSTZ, 4 }, // X
-	{ { {-1,+1}, {-1, 0}, { 0, 0}, {+1, 0}, { 0,-1} }, &PIECE_OFFSETS_JLSTZ, 7 }, // F
-	{ { {+1,+1}, {-1, 0}, { 0, 0}, {+1, 0}, { 0,-1} }, &PIECE_OFFSETS_JLSTZ, 6 }, // Ff
-	{ { { 0,+1}, {+1,+1}, { 0, 0}, {-1,-1}, { 0,-1} }, &PIECE_OFFSETS_JLSTZ, 3 }, // St
-	{ { {-1,+1}, { 0,+1}, { 0, 0}, { 0,-1}, {+1,-1} }, &PIECE_OFFSETS_JLSTZ, 2 }, // Zt
-	{ { {-1,+1}, {-1, 0}, { 0, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_JLSTZ, 7 }, // Jt
-	{ { {+1,+1}, {-2, 0}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 6 }, // Lt
-	{ { { 0,+1}, {-1, 0}, { 0, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_JLSTZ, 5 }, // Yf
-	{ { { 0,+1}, {-2, 0}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 5 }, // Y
-	{ { { 0,+1}, {+1,+1}, {-2, 0}, {-1, 0}, { 0, 0} }, &PIECE_OFFSETS_JLSTZ, 3 }, // Sw
-	{ { {-1,+1}, { 0,+1}, { 0, 0}, {+1, 0}, {+2, 0} }, &PIECE_OFFSETS_JLSTZ, 2 }, // Zw
-	{ { {-1,+1}, { 0,+1}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 4 }, // P
-	{ { { 0,+1}, {+1,+1}, {-1, 0}, { 0, 0}, {+1, 0} }, &PIECE_OFFSETS_JLSTZ, 4 }  // Q
-};
-
-struct Level {
-	// how fast a piece falls.
-	float fallDelay;
-	
-	// how fast a piece locks in place.
-	float lockDelay;
-	
-	// which range of pieces from PIECE_DEFINITIONS to spawn.
-	std::pair<int, int> piecesRange;
-	
-	// what color the background is.
-	sf::Color bgColor;
-};
-
-Level getLevel(int index) {
-	// tried to be mindful about when things happen in this game.
-	// https://www.desmos.com/calculator/mktrzc7bs9
-	// and to see pretty much everything in this game,
-	// you just have to clear 120 lines.
-	std::pair<int, int> piecesRange;
-	if (index < 10) {
-		piecesRange = { 0, 7 };
-	} else if (index < 35 ) {
-		// once level 10 rolls around, start spawning pentominos
-		piecesRange = { 0, std::min(7 + (index - 10) / 2, 19) };
-	} else {
-		// if you're this far, you don't need tetrominos any more.
-		piecesRange = { 7, 19 };
-	}
+	// Start decoding the pictures on other threads right away, so they're
+	// ready by the time the window is. (Reading the files, too, unless
+	// they're baked in.)
+	AssetStore assets(argc > 0 ? argv[0] : nullptr);
+	sf::Image images[ASSET_COUNT];
+	auto decode = [&assets, &images](Asset asset) {
+		if (!assets.read(asset)) return false;
+		AssetData file = assets.get(asset);
+		return images[asset].loadFromMemory(file.data, file.size);
+	};
+	std::future<bool> decoding[] = {
+		std::async(std::launch::async, decode, ASSET_TILES),
+		std::async(std::launch::async, decode, ASSET_BACKGROUND),
+		std::async(std::launch::async, decode, ASSET_FRAME),
+	};
 	
-	return Level({
-		(float)std::max(0.2, 0.4 - (float)index * 0.01),
-		(float)std::max(0.3, 0.7 - (float)index * 0.01),
-		piecesRange,
-		sf::Color(
-			255, // meant to later look like a sunset,
-			// then later look like the sky is blood red.
-			std::min(std::max(96, 260 - index * 3), 255),
-			std::min(std::max(80, 270 - index * 4), 255)
-		)
-	});
-}
-
-// Rotates a vector in 90 degree increments.
-// `rotation` is given in these 90deg increments, so ±2 means 180 degrees.
-template<typename T>
-sf::Vector2<T> rotate(const sf::Vector2<T>& v, int rotation) {
-	// restricts range to 0, 1, 2, 3
-	// (or -1, 0, 1, ±2 if you're signed)
-	rotation &= 3;
-	
-	switch (rotation) {
-		default: case 0: return { v.x, v.y };
-		break; case 1: return { +v.y, -v.x };
-		break; case 2: return { -v.x, -v.y };
-		break; case 3: return { -v.y, +v.x };
-		break;
+	ReplayReader replayReader;
+	if (replayPath && !replayReader.open(replayPath)) {
+		printf("couldn't read replay %s! giving up\n", replayPath);
+		return EXIT_FAILURE;
 	}
-}
-
-struct Piece {
-	// Each piece has a reference to its definition,
-	// to retrieve tile color and rotation nudge tables.
-	const PieceDefinition* definition;
-	
-	// Each piece is made up of several tiles relative to its position.
-	std::vector<sf::Vector2i> tiles;
-	
-	// The position of the piece on the board.
-	sf::Vector2i position;
-	
-	// The rotation the piece is at.
-	int rotation = 0;
-	
-	// The piece's initial position on the board.
-	static constexpr std::pair<int, int> INITIAL_POSITION = { 4, 20 };
-	
-	Piece(int id = 0) { reset(id); }
-	
-	// I'm lazy. This is basically the constructor again.
-	void reset(int id = 0) {
-		definition = &PIECE_DEFINITIONS[id];
-		
-		tiles.clear();
-		tiles.reserve(definition->tiles.size());
-		for (const auto& tile : definition->tiles)
-			tiles.push_back({ tile.first, tile.second });
-		
-		position = { INITIAL_POSITION.first, INITIAL_POSITION.second };
-		rotation = 0;
+	if (replayPath && !replayReader.isFor(pieceSet)) {
+		printf("replay %s was recorded with other pieces (see --pieces)! giving up\n", replayPath);
+		return EXIT_FAILURE;
 	}
 	
-	// Attempts to rotate the piece by the specified amount.
-	// Returns true if rotation succeeded.
-	bool rotate(const Board& board, int direction) {
-		int oldRotation = rotation;
-		rotation = (rotation + direction) & 3;
-		for (auto& tile : tiles) {
-			// gosh, eliding `this->` really sucks..
-			// i miss rust so much.
-			// yes, this is meant to be a call to that template function,
-			// not a recursive call.
-			tile = ::rotate(tile, direction);
+	// Initialize all the parts of the game.
+	uint64_t seed = replayPath ? replayReader.seed : time(0);
+	Versus versus(opponents, seed, pieceSet);
+	
+	// Netplay finds the other player before anything else, since the seed
+	// comes from the host. (Time here is on its own clock, the link's.)
+	NetplayLink link;
+	sf::Clock linkClock;
+	std::unique_ptr<RollbackSession> session;
+	if (netplaying) {
+		UdpAddress peer;
+		if (joinAddress && !peer.resolve(joinAddress, joinPort)) {
+			printf("couldn't find %s\n", joinAddress);
+			return EXIT_FAILURE;
 		}
-		
-		// The core of SRS:
-		int checks = definition->getOffsetCheckLength(oldRotation, rotation);
-		for (int i = 0; i < checks; i++) {
-			auto offset = definition->getOffset(oldRotation, rotation, i);
-			
-			// Nudge piece in the offset direction.
-			if (fits(board, offset)) {
-				// If it fits, keep this new position
-				// and stop doing further checks.
-				position += offset;
-				return true;
-			}
+		if (!link.open(hostPort, peer, joinAddress ? 1 : 0, seed)) {
+			printf("couldn't open a socket\n");
+			return EXIT_FAILURE;
 		}
-		// If you get past here, all checks failed.
-		
-		// Undo rotation if no offsets actually fit.
-		rotation = oldRotation;
-		for (auto& tile : tiles) {
-			tile = ::rotate(tile, -direction);
+		link.shim.latency = fakeLag;
+		link.shim.lossRate = fakeLoss;
+		link.shim.rng.reseed(seed);
+		
+		if (joinAddress) printf("joining %s:%d...\n", joinAddress, joinPort);
+		else printf("waiting on port %d for somebody to join...\n", hostPort);
+		
+		// Whoever's hosting waits as long as it takes.
+		while (!link.connect(linkClock.getElapsedTime().asSeconds())) {
+			if (joinAddress && linkClock.getElapsedTime().asSeconds() > NetplayLink::TIMEOUT) {
+				printf("nobody's there\n");
+				return EXIT_FAILURE;
+			}
+			sf::sleep(sf::milliseconds(10));
 		}
-		
-		return false;
+		printf("connected\n");
+		session.reset(new RollbackSession(link.player, link.seed, pieceSet));
 	}
+	Game& game = session ? session->getLocalGame() : versus.getPlayer();
 	
-	// Check if a piece fits on the board, not overlapping any non-zero tile.
-	// Optionally accepts an offset to the piece, a direction to bump its
-	// current position in.
-	bool fits(const Board& board, const sf::Vector2i offset = { 0, 0 }) const {
-		return fitsAbs(board, position + offset);
-	}
-	
-	// Check if a piece fits on the board, not overlapping any non-zero tile.
-	// This does not use the piece's position.
-	bool fitsAbs(const Board& board, const sf::Vector2i absPosition) const {
-		for (const auto& tile : tiles)
-			if (board.getTile(absPosition + tile) > 0)
-				return false;
-		return true;
-	}
+	// The other boards down the side: every bot, or the other player.
+	int sideBoards = session ? 1 : opponents;
 	
-	// Returns the lowest Y coordinate this piece can fall to,
-	// in its current position. Used for hard drops.
-	int getDropYCoord(const Board& board) const {
-		int y = position.y - 1;
-		
-		while (y >= 0) {
-			if (fitsAbs(board, { position.x, y }))
-				y--;
-			else return ++y;
-		}
-		
-		return 0;
-	}
-	
-	// Writes the piece to the board.
-	void place(Board& board) const {
-		for (const auto& tile : tiles) {
-			board.setTile(tile + position, definition->color);
-		}
-	}
-};
-
-// Piece Randomizer, where every piece has an equal chance of being drawn.
-// https://harddrop.com/wiki/Random_Generator
-struct PieceBag {
-	// If you display the next queue on screen, you need this buffer area--
-	// otherwise, every 7 pieces you'd have an empty queue!
-	static const int MIN_VISIBLE = 3;
-	
-	// The range of piece IDs to generate in the RNG.
-	// .first is lower bound, .second is exclusive upper bound.
-	std::pair<int, int> piecesRange = { 0, PIECE_DEFINITIONS.size() };
-	
-	// The bag!
-	std::deque<int> bag;
-	
-	PieceBag() { reset(); }
-	
-	void reset() {
-		bag.clear();
-		setPiecesRange(0, 7);
-		pushNewSet();
-	}
+	// The bots step across every core. (Without any, there's no point
+	// starting up threads.)
+	WorkStealingPool pool(opponents > 0 ? 0 : 1);
 	
-	// Select which subset of PIECE_DEFINITIONS the bag will take from.
-	void setPiecesRange(int lower, int upper = 0) {
-		if (lower > upper) std::swap(lower, upper);
-		if (upper == 0) return;
-		piecesRange = { lower, upper };
+	ReplayWriter recorder;
+	if (recordPath && !recorder.open(recordPath, seed, pieceSet)) {
+		printf("couldn't write replay %s! giving up\n", recordPath);
+		return EXIT_FAILURE;
 	}
 	
-	// Pops a piece from the front of the queue.
-	// (Automatically gets new pieces if end of queue is then visible.)
-	int getNext() {
-		if (bag.size() <= MIN_VISIBLE)
-			pushNewSet();
-		
-		// oh my god C++ just return the thing you pop from pop_front you jerk
-		int result = *bag.cbegin();
-		bag.pop_front();
-		return result;
+	// Only costs anything while it's being looked at, or written out.
+	FrameProfiler profiler;
+	if (profilePath && !profiler.openCsv(profilePath)) {
+		printf("couldn't write profile %s! giving up\n", profilePath);
+		return EXIT_FAILURE;
 	}
 	
-	// Pushes a new batch of BAG_SIZE pieces to the end of the queue.
-	void pushNewSet() {
-		int rangeSize = piecesRange.second - piecesRange.first;
-		
-		std::vector<int> shuffle;
-		shuffle.reserve(rangeSize);
-		
-		for (int i = 0; i < rangeSize; i++)
-			shuffle.push_back((i % rangeSize) + piecesRange.first);
-		
-		for (int i = shuffle.size() - 1; i > 0; i--) {
-			int j = rand() % (i + 1);
-			std::swap(shuffle[i], shuffle[j]);
-		}
-		
-		for (const auto& p : shuffle)
-			bag.push_back(p);
-	}
-};
-
-// tried to center a smaller rect inside a larger rectangle. untested.
-template<typename T>
-sf::Rect<T> centerRectWithin(const sf::Rect<T>& withinThat, const sf::Rect<T>& centerThis) {
-	return sf::Rect<T>(
-		withinThat.left - (centerThis.left / 2) + (withinThat.width  - (centerThis.width  / 2)) / 2,
-		withinThat.top  - (centerThis.top  / 2) + (withinThat.height - (centerThis.height / 2)) / 2,
-		centerThis.width, centerThis.height
-	);
-}
-
-int main() {
-	// Seed RNG.
-	srand(time(0));
-	
-	// Initialize all the parts of the game.
-	Board board;
-	Piece piece;
-	
-	PieceBag bag;
-	piece.reset(bag.getNext());
-	
 	// Create the dang window.
-	sf::RenderWindow window(sf::VideoMode(320, 480), "Normal Tetris");
-	window.setVerticalSyncEnabled(true); // Run at a sensible speed.
-	
-	// Cool pictures
-	sf::Texture texTiles, texBackground, texFrame;
+	// (Versus mode gets a strip down the right for the opponents' boards.)
+	const int VERSUS_PANEL_WIDTH = 220;
+	sf::RenderWindow window(sf::VideoMode(320 + (sideBoards > 0 ? VERSUS_PANEL_WIDTH : 0), 480), "Normal Tetris");
+	window.setVerticalSyncEnabled(!uncapped); // Run at a sensible speed.
 	
 	// Cool font
 	sf::Font fntComicSans;
+	bool assetsFound = assets.read(ASSET_FONT);
+	if (assetsFound) {
+		AssetData file = assets.get(ASSET_FONT);
+		assetsFound = fntComicSans.loadFromMemory(file.data, file.size);
+	}
+	
+	// Wait for the pictures. (Every one of them, even if one's missing.)
+	for (auto& decoded : decoding)
+		assetsFound &= decoded.get();
 	
 	// Error out if I can't find assets.
-	if (!texTiles.loadFromFile("images/tiles.png")
-	||  !texBackground.loadFromFile("images/background.png")
-	||  !texFrame.loadFromFile("images/frame.png")
-	||  !fntComicSans.loadFromFile("images/comic.ttf")) {
+	if (!assetsFound) {
 		printf("assets missing! giving up\n");
 		return EXIT_FAILURE;
 	}
 	
-	// String buffers.
-	char strStats[32] = "Press R to begin!";
-	char strHighScore[32] = "Fill lines to score points!";
+	// Cool pictures
+	sf::Texture texBackground;
+	texBackground.loadFromImage(images[ASSET_BACKGROUND]);
 	
 	// Helper function to initialize a bunch of
 	// text objects with the correct styles.
@@ -509,11 +273,14 @@ int main() {
 		Board::POSITION.second - 2
 	});
 	
+	const unsigned STATS_SIZE = 30, HIGH_SCORE_SIZE = 18;
+	
 	// Set up the text object that displays statistics about the game,
-	// such as score and level.
+	// such as score and level. (Before the first game, it's instructions.)
 	sf::Text txtStats;
 	styleText(txtStats);
-	txtStats.setString(strStats);
+	txtStats.setCharacterSize(STATS_SIZE);
+	txtStats.setString("Press R to begin!");
 	txtStats.setPosition({
 		2,
 		Board::POSITION.second + Board::VISIBLE_HEIGHT * Board::TILE_SIZE + 8
@@ -522,10 +289,39 @@ int main() {
 	// Set up the high score label.
 	sf::Text txtHighScore;
 	styleText(txtHighScore);
-	txtHighScore.setCharacterSize(18);
-	txtHighScore.setString(strHighScore);
+	txtHighScore.setCharacterSize(HIGH_SCORE_SIZE);
+	txtHighScore.setString("Fill lines to score points!");
 	txtHighScore.setPosition({ 2, 2 });
 	
+	// Once a game starts, those two get swapped out for fixed labels with
+	// numbers next to them. The numbers come out of a pre-rendered digit
+	// atlas, so they don't make SFML lay out any text when they change.
+	// (They share a texture with the tiles and the frame.)
+	TextureAtlas atlas;
+	if (!atlas.build(images[ASSET_FRAME], images[ASSET_TILES], fntComicSans, styleText, { STATS_SIZE, HIGH_SCORE_SIZE })) {
+		printf("couldn't render digits! giving up\n");
+		return EXIT_FAILURE;
+	}
+	const DigitAtlas& digitAtlas = atlas.digits;
+	
+	sf::Text txtStatsLabels;
+	styleText(txtStatsLabels);
+	txtStatsLabels.setCharacterSize(STATS_SIZE);
+	txtStatsLabels.setString("Score: \nLevel ");
+	txtStatsLabels.setPosition(txtStats.getPosition());
+	
+	sf::Text txtHighScoreLabel;
+	styleText(txtHighScoreLabel);
+	txtHighScoreLabel.setCharacterSize(HIGH_SCORE_SIZE);
+	txtHighScoreLabel.setString("High Score: ");
+	txtHighScoreLabel.setPosition(txtHighScore.getPosition());
+	
+	// (The numbers start where their labels end.)
+	HudNumber hudScore(digitAtlas, STATS_SIZE, txtStatsLabels.findCharacterPos(7), 8);
+	HudNumber hudLevel(digitAtlas, STATS_SIZE, txtStatsLabels.findCharacterPos(14));
+	HudNumber hudHighScore(digitAtlas, HIGH_SCORE_SIZE, txtHighScoreLabel.findCharacterPos(12), 8);
+	bool showingStats = false;
+	
 	// Set up the title/game over screen label.
 	sf::Text txtBigText;
 	styleText(txtBigText);
@@ -536,293 +332,310 @@ int main() {
 		Board::POSITION.second + Board::VISIBLE_HEIGHT * Board::TILE_SIZE / 2
 	});
 	
-	sf::Sprite sprTile(texTiles);
+	BoardRenderer boardRenderer(atlas.texture, sf::Vector2f(atlas.tilesRect.left, atlas.tilesRect.top));
 	sf::Sprite sprBackground(texBackground);
-	sf::Sprite sprFrame(texFrame);
+	sf::Sprite sprFrame(atlas.texture, atlas.frameRect);
 	
-	// loose game state
-	// input stuff.
-	int dx = 0, rotate = 0;
-	bool hardDrop = false;
+	// The opponents, all in one draw call, from the same texture.
+	MiniBoardRenderer miniBoards(atlas.texture,
+		sf::Vector2f(atlas.tilesRect.left, atlas.tilesRect.top),
+		sf::Vector2f(atlas.whiteRect.left + TextureAtlas::WHITE_SIZE / 2, atlas.whiteRect.top + TextureAtlas::WHITE_SIZE / 2),
+		sideBoards, { 320 + 6, 8, VERSUS_PANEL_WIDTH - 8, 480 - 16 });
 	
-	// Fall Speed timers.
-	float timer = 0;
+	// How much garbage is on its way in: a bar up the left of the board.
+	sf::RectangleShape garbageMeter;
+	garbageMeter.setFillColor(sf::Color(220, 40, 40));
 	
-	// Extremely basic Delayed Auto Shift (DAS)
-	float moveDelayInitial = 0.175, moveDelay = 0.0625;
-	float moveTimer = 0;
-	bool moveRepeated = false; // have we moved once yet?
-	bool piecePlaced = false;
-	
-	bool gameOver = true; // ssshhh! the title screen is just if the game over screen said something else
-	
-	long int score = 0, highScore = 13370;
-	int lines = 0;
-	int levelNum = 0;
+	// The profiler's table goes just under the high score, over the top of
+	// the board (which is empty most of the time anyway).
+	ProfilerOverlay profilerOverlay(styleText, { 2, 26 });
+	profilerOverlay.visible = showProfiler;
 	
 	// Game clock.
 	sf::Clock clock;
 	sf::Time time;
 	
-	// Wasn't meant to permanently be here, but it is now.
-	sf::RectangleShape dbgRect;
-	dbgRect.setFillColor(sf::Color::White);
+	// The game steps at a fixed rate, separately from frames.
+	FixedTimestep timestep;
+	
+	// Input waiting for the next step. Key presses stick around until a step
+	// actually happens, since (uncapped) frames can be shorter than a step.
+	InputFrame input;
+	
+	// The keyboard gets read on its own thread, about once a millisecond, on
+	// Windows, and once a frame everywhere else (see inputsampler.hpp).
+	// (Not needed when playing a replay.)
+	InputSampler sampler;
+	if (!replayPath) sampler.run();
+	double lastNow = sampler.now();
+	
+	// Counts frames, for the allocation report.
+	long int frameNumber = 0;
+	
+	// How far into the replay we are, in steps and in recorded seconds.
+	uint64_t replayFrames = 0;
+	double replayTime = 0;
+	bool replayDone = false;
+	
+	// Where the falling piece was before the last step, for drawing it
+	// partway between there and where it is now.
+	Vec2i lastPosition = game.piece.position;
+	int lastRotation = game.piece.rotation;
+	long int lastPieces = game.pieces;
+	
+	// Advances the game one step, and keeps the text in sync with it.
+	bool gameRan = false;
+	auto stepGame = [&](const InputFrame& input, float dt) {
+		bool wasGameOver = game.gameOver;
+		game.step(input, dt);
+		recorder.record(input, dt);
+		
+		if (wasGameOver && !game.gameOver) {
+			txtBigText.setString("");
+			versus.startOpponents();
+		}
+		if (!wasGameOver && game.gameOver)
+			txtBigText.setString("Game over!\n(R: Restart)");
+		
+		if (!wasGameOver || !game.gameOver)
+			gameRan = true;
+	};
+	
+	// Netplay's version: one input per step, whenever the session's ready
+	// for it. (It keeps any taps until then.)
+	bool linkLost = false;
+	auto stepNetplay = [&]() {
+		if (linkLost || session->shouldWait()) return;
+		if (session->advance(input)) {
+			input.clearTaps();
+			gameRan = true;
+		}
+	};
+	
+	// Rollbacks can change who's won after the fact, so the text just
+	// follows whatever the games say now.
+	const char* netplayText = nullptr;
+	auto updateNetplayText = [&]() {
+		const char* text = linkLost ? "Connection\nlost!"
+			: game.gameOver ? "You lose!\n(R: Restart)"
+			: session->getRemoteGame().gameOver ? "You win!" : "";
+		if (text != netplayText) {
+			netplayText = text;
+			txtBigText.setString(text);
+		}
+	};
 	
 	while (window.isOpen()) {
+		long int allocationsBefore = getAllocationCount();
+		
 		// Get delta time.
 		auto dt = clock.restart();
 		time += dt;
 		
-		// Reset input state
-		dx = 0; rotate = 0; hardDrop = false;
+		profiler.enabled = profilerOverlay.visible || profiler.csv;
 		
 		// Poll window & input events.
-		sf::Event e;
-		while (window.pollEvent(e)) {
-			if (e.type == sf::Event::Closed)
-				window.close();
-			
-			// These have key repeat.
-			// SCOPE: replace with own DAS system
-			if (e.type == sf::Event::KeyPressed) {
-				switch (e.key.code) {
-					case sf::Keyboard::Z: rotate = -1; break;
-					case sf::Keyboard::X: rotate = +1; break;
-					case sf::Keyboard::Up: hardDrop = true; break;
-					case sf::Keyboard::Left:  if (!moveRepeated && moveTimer == 0) dx = -1; break;
-					case sf::Keyboard::Right: if (!moveRepeated && moveTimer == 0) dx = +1; break;
-					case sf::Keyboard::R: {
-						gameOver = false;
-						
-						board.clear();
-						bag.reset();
-						piece.reset(bag.getNext());
-						
-						score = 0; lines = 0;
-						
-						moveRepeated = false;
-						moveTimer = 0; timer = 0;
-						
-						txtBigText.setString("");
-					} break;
-				}
+		{
+			ProfileScope scope(profiler, FrameProfiler::EVENTS);
+			sf::Event e;
+			while (window.pollEvent(e)) {
+				if (e.type == sf::Event::Closed)
+					window.close();
+				
+				if (e.type == sf::Event::LostFocus)   sampler.focused = false;
+				if (e.type == sf::Event::GainedFocus) sampler.focused = true;
+				
+				// The game's keys come from the sampler, not from here.
+				if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::F3)
+					profilerOverlay.visible = !profilerOverlay.visible;
 			}
 		}
 		
-		levelNum = lines / 6; // extremely simple level system
-		Level levelInfo = getLevel(levelNum);
-		levelNum++; // oops! i multiply by this number!
-		
-		// Timer logic
-		if (!sf::Keyboard::isKeyPressed(sf::Keyboard::Left)
-		&&  !sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) {
-			// Reset timer if no directions are being held.
-			moveTimer = 0;
-			moveRepeated = false;
-		} else {
-			// Increment timer by delta time.
-			moveTimer += dt.asSeconds();
-		}
-		
-		// Respond to held keys.
-		// (There's a different delay based on if it's the first repetition or
-		//  if it's any beyond; `moveRepeated` keeps track of that.)
-		if ((!moveRepeated && moveTimer > moveDelayInitial)
-		||  ( moveRepeated && moveTimer > moveDelay)) {
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left))  dx = -1;
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) dx = +1;
-			moveTimer = 0;
-			moveRepeated = true;
-		}
-		
-		// This doesn't have key repeat.
-		float fallDelay = levelInfo.fallDelay;
-		if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) fallDelay /= 6.0;
-		
-		bag.setPiecesRange(levelInfo.piecesRange.first, levelInfo.piecesRange.second);
-		
 		// UPDATE
-		if (!gameOver) {
-			// Move piece
-			if (dx != 0) {
-				if (piece.fits(board, { dx, 0 })) {
-					// janky, but resets the timer if piece
-					// is either moved off of or onto a surface
-					// (to make lockDelay easier to implement)
-					if (!piece.fits(board, { 0, -1 }))
-						timer = 0;
-					piece.position.x += dx;
-					if (!piece.fits(board, { 0, -1 }))
-						timer = 0;
-				}
-			}
-			
-			// Drop piece all the way to the bottom
-			if (hardDrop) {
-				piece.position.y = piece.getDropYCoord(board);
-				piecePlaced = true;
-				timer = 0;
-			}
-			
-			// Rotate piece
-			if (rotate != 0)
-				piece.rotate(board, rotate);
-
-			// Fall one tile per tick
-			timer += dt.asSeconds();
-			if (piece.fits(board, { 0, -1 })) {
-				if (timer > fallDelay) {
-					piece.position.y -= 1;
-					timer = 0;
-				}
-			} else {
-				if (timer > levelInfo.lockDelay) {
-					piecePlaced = true;
-					timer = 0;
-				}
-			}
-			
-			// If piece was hard dropped or it locked,..
-			if (piecePlaced) {
-				// ...write it to the board.
-				piece.place(board);
+		{
+			ProfileScope scope(profiler, FrameProfiler::UPDATE);
+			gameRan = false;
+			if (!replayPath) {
+				// Catch up on however many steps this frame took. Each step
+				// gets split up wherever a key changed partway through it,
+				// so the change happens exactly when it did.
+				sampler.poll();
+				double now = sampler.now();
+				int ticks = timestep.advance(now - lastNow);
+				lastNow = now;
 				
-				// and give out the points for placing a piece.
-				score += levelNum;
+				// Whatever the other player's sent, before anything runs.
+				if (session && !linkLost)
+					linkLost = !link.receiveInputs(*session, linkClock.getElapsedTime().asSeconds());
 				
-				// After that, spawn a new piece.
-				piece.reset(bag.getNext());
-				piecePlaced = false;
+				double tickStart = now - timestep.accumulator - ticks * FixedTimestep::TICK_SECONDS;
+				for (int i = 0; i < ticks; i++) {
+					lastPosition = game.piece.position;
+					lastRotation = game.piece.rotation;
+					lastPieces = game.pieces;
+					
+					double tickEnd = tickStart + FixedTimestep::TICK_SECONDS;
+					double stepStart = tickStart;
+					if (session) {
+						while (const KeyEvent* event = sampler.peek()) {
+							if (event->time >= tickEnd) break;
+							event->applyTo(input);
+							sampler.pop();
+						}
+						stepNetplay();
+						tickStart = tickEnd;
+						continue;
+					}
+					
+					while (const KeyEvent* event = sampler.peek()) {
+						if (event->time >= tickEnd) break;
+						if (event->time > stepStart) {
+							stepGame(input, event->time - stepStart);
+							input.clearTaps();
+							stepStart = event->time;
+						}
+						event->applyTo(input);
+						sampler.pop();
+					}
+					
+					stepGame(input, tickEnd - stepStart);
+					input.clearTaps();
+					tickStart = tickEnd;
+					
+					// Then everybody else, all at once. The round's over
+					// when the player is, or when nobody else is left.
+					if (opponents > 0 && !game.gameOver) {
+						versus.stepOpponents(FixedTimestep::TICK_SECONDS, pool);
+						versus.exchangeGarbage();
+						if (versus.getOpponentsLeft() == 0) {
+							game.gameOver = true;
+							txtBigText.setString("You win!\n(R: Restart)");
+						}
+					}
+				}
 				
-				// Bump up if not fitting on board
-				if (!piece.fits(board)) {
-					piece.position.y++;
-					// *Then* game over if it still doesn't fit.
-					if (!piece.fits(board)) {
-						gameOver = true;
-						txtBigText.setString("Game over!\n(R: Restart)");
+				// And this side's inputs back (every tick's worth at once).
+				if (session && !linkLost)
+					link.sendInputs(*session, linkClock.getElapsedTime().asSeconds());
+			} else if (!replayDone) {
+				// Replays ignore the keyboard, and instead play back recorded steps:
+				// either until they catch up with the clock, or for most of a frame.
+				sf::Clock budget;
+				InputFrame recorded;
+				float recordedDt;
+				while (replayFast ? budget.getElapsedTime() < sf::milliseconds(15)
+				                  : replayTime < time.asSeconds()) {
+					if (!replayReader.next(recorded, recordedDt)) {
+						replayDone = true;
+						break;
 					}
+					stepGame(recorded, recordedDt);
+					replayFrames++;
+					replayTime += recordedDt;
+				}
+				
+				if (replayDone) {
+					bool ok = replayReader.matches(game, replayFrames);
+					printf("replay %s: %s (score %ld, lines %d)\n", replayPath,
+						ok ? "ok" : "MISMATCH", game.score, game.lines);
 				}
 			}
 			
-			// Check for and remove filled lines
-			int clearedLines = board.removeFilledLines();
-			if (clearedLines) {
-				lines += clearedLines;
-				score += clearedLines * 50 * levelNum;
+			// Only touch the numbers if the game actually ran this frame.
+			// (They only get laid out again if they've changed.)
+			if (session) updateNetplayText();
+			if (gameRan) {
+				showingStats = true;
+				hudScore.set(game.score);
+				hudLevel.set(game.levelNum);
+				hudHighScore.set(game.highScore);
 			}
-			
-			// Update high score if you've exceeded it.
-			if (score > highScore)
-				highScore = score;
-			
-			// Update text label showing score and level.
-			snprintf(strStats, sizeof(strStats), "Score: %08d\nLevel %d", score, levelNum);
-			txtStats.setString(strStats);
-			
-			// Update high score label.
-			snprintf(strHighScore, sizeof(strHighScore), "High Score: %08d", highScore);
-			txtHighScore.setString(strHighScore);
 		}
 		
 		// DRAW
 		
-		window.clear(sf::Color::White);
-		
-		// Tint background.
-		sprBackground.setColor(levelInfo.bgColor);
-		window.draw(sprBackground);
-		
-		// Utility function to easily set sprite texture rect to
-		// the proper tile, based on tile index.
-		auto setTextureTileIndex = [&sprTile](int i){
-			auto r = sf::IntRect(i * Board::TILE_SIZE, 0, Board::TILE_SIZE, Board::TILE_SIZE);
-			sprTile.setTextureRect(r);
-		};
-		
-		// Draw board.
-		for (int j = 0; j < Board::HEIGHT; j++) {
-			sprTile.setPosition(board.getTilePosition({ -1, j }));
-			for (int i = 0; i < Board::WIDTH; i++) {
-				sprTile.move(Board::TILE_SIZE, 0);
-				
-				if (board.board[j][i] == 0) continue;
-				
-				setTextureTileIndex(board.board[j][i]);
-				window.draw(sprTile);
+		{
+			ProfileScope scope(profiler, FrameProfiler::DRAW_BOARD);
+			window.clear(sf::Color::White);
+			
+			// Tint background.
+			sprBackground.setColor(sf::Color(game.level.bgColor));
+			window.draw(sprBackground);
+			
+			// Draw board, current piece, and the next queue.
+			// The piece slides from where it was to where it is over the course
+			// of a step, unless it's a whole new piece, or it jumped (or spun).
+			sf::Vector2f pieceOffset = { 0, 0 };
+			Vec2i moved = game.piece.position - lastPosition;
+			if (!replayPath && game.pieces == lastPieces && game.piece.rotation == lastRotation
+			&&  abs(moved.x) <= 1 && abs(moved.y) <= 1) {
+				float behind = 1 - timestep.getAlpha();
+				pieceOffset = { -moved.x * behind, -moved.y * behind };
 			}
-		}
-		
-		// Draw current Piece
-		if (!gameOver) {
-			setTextureTileIndex(piece.definition->color);
-			for (const auto& tile : piece.tiles) {
-				sprTile.setPosition(board.getTilePosition(piece.position + tile));
-				window.draw(sprTile);
+			boardRenderer.update(game, pieceOffset);
+			boardRenderer.draw(window, game.gameOver);
+			
+			// Draw frame around the board.
+			window.draw(sprFrame);
+			
+			if (sideBoards > 0) {
+				int incoming = std::min(game.garbageQueued, (int)Board::VISIBLE_HEIGHT);
+				float bottom = Board::POSITION.second + Board::VISIBLE_HEIGHT * Board::TILE_SIZE;
+				garbageMeter.setSize({ 4, (float)(incoming * Board::TILE_SIZE) });
+				garbageMeter.setPosition(Board::POSITION.first - 6, bottom - incoming * Board::TILE_SIZE);
+				window.draw(garbageMeter);
+				
+				if (session) miniBoards.update(0, session->getRemoteGame());
+				else miniBoards.update(versus);
+				miniBoards.draw(window);
 			}
 		}
 		
-		// Draw frame around the board.
-		window.draw(sprFrame);
-		
 		// Draw the text labels.
-		window.draw(txtStats);
-		window.draw(txtHighScore);
-		
-		// Draw the big text that lays atop the board.
-		window.draw(txtBigText);
-		
-		// Draw the Next Queue
-		// (Slightly a disaster, but good enough.)
-		if (!gameOver) {
-			window.draw(txtNext);
-			
-			for (int i = 0; i < PieceBag::MIN_VISIBLE; i++) {
-				const auto& definition = PIECE_DEFINITIONS[bag.bag[i]];
-				
-				setTextureTileIndex(definition.color);
-				
-				const sf::IntRect NEXT_BOX_SIZE = { 0, 0, 4, 2 };
-				sf::IntRect pieceRect = definition.getPieceRect();
-				// (i don't think `centerRectWithin` actually works, oops)
-				sf::FloatRect rect = centerRectWithin((sf::FloatRect)NEXT_BOX_SIZE, (sf::FloatRect)pieceRect);
-				rect.left -= 0.5; rect.top += 0.5;
-				
-				// stumble through rectangle math.
-				
-				const sf::Vector2f TO_THE_RIGHT_OF_THE_BOARD = {
-					Board::POSITION.first + Board::WIDTH * Board::TILE_SIZE + 24,
-					Board::POSITION.second + 32
-				};
-				// oh gosh, this is all for centering the I and O pieces visually.
-				sf::Vector2f center = TO_THE_RIGHT_OF_THE_BOARD + sf::Vector2f({
-					Board::TILE_SIZE * rect.left,
-					Board::TILE_SIZE * (NEXT_BOX_SIZE.height * (i + 1) - rect.top)
-				});
-				
-				// temporary background rect
-				dbgRect.setPosition(TO_THE_RIGHT_OF_THE_BOARD + sf::Vector2f({
-					(float)(NEXT_BOX_SIZE.left),
-					(float)(NEXT_BOX_SIZE.top + Board::TILE_SIZE * NEXT_BOX_SIZE.height * i)
-				}));
-				dbgRect.setSize(sf::Vector2f({
-					(float)(Board::TILE_SIZE * NEXT_BOX_SIZE.width),
-					(float)(Board::TILE_SIZE * NEXT_BOX_SIZE.height - 1)
-				}));
-				window.draw(dbgRect);
-				
-				for (const auto& tile : definition.tiles) {
-					sprTile.setPosition(center + sf::Vector2f({
-						(float)tile.first * Board::TILE_SIZE,
-						(float)tile.second * -Board::TILE_SIZE
-					}));
-					window.draw(sprTile);
-				}
+		{
+			ProfileScope scope(profiler, FrameProfiler::DRAW_TEXT);
+			if (showingStats) {
+				window.draw(txtStatsLabels);
+				window.draw(txtHighScoreLabel);
+				hudScore.draw(window);
+				hudLevel.draw(window);
+				hudHighScore.draw(window);
+			} else {
+				window.draw(txtStats);
+				window.draw(txtHighScore);
 			}
+			
+			// Draw the big text that lays atop the board.
+			window.draw(txtBigText);
+			
+			// Label the Next Queue.
+			if (!game.gameOver)
+				window.draw(txtNext);
+			
+			// (The profiler's own text counts too.)
+			profilerOverlay.update(profiler, dt.asSeconds());
+			profilerOverlay.draw(window);
 		}
 		
-		window.display();
+		{
+			ProfileScope scope(profiler, FrameProfiler::DISPLAY);
+			window.display();
+		}
+		profiler.endFrame();
+		
+		// The steady-state loop shouldn't allocate at all,
+		// so complain about any frame that does.
+		// (Except for the profiler's table, when it changes.)
+		if (COUNTING_ALLOCATIONS) {
+			long int allocations = getAllocationCount() - allocationsBefore;
+			if (allocations > 0)
+				printf("frame %ld: %ld allocation(s)\n", frameNumber, allocations);
+		}
+		frameNumber++;
 	}
-
+	
+	if (recorder.isOpen() && !recorder.finish(game))
+		printf("couldn't finish writing replay %s!\n", recordPath);
+	
 	return EXIT_SUCCESS;
 }
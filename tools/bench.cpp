@@ -0,0 +1,593 @@
+// Guideline Tetris!!
+// Benchmarks for the game core's hot paths, on seeded (so, identical every
+// run) fixtures. Prints a table as it goes, and writes every result as JSON,
+// for comparing runs and catching regressions.
+
+// usage: bench [-s seed] [-r repeats] [-o results.json] [-g game pieces]
+// Without -o, the JSON goes to stdout (and the table to stderr).
+
+#include "../core/board.hpp"
+#include "../core/bot.hpp"
+#include "../core/evaluate.hpp"
+#include "../core/game.hpp"
+#include "../core/lookahead.hpp"
+#include "../core/movegen.hpp"
+#include "../core/piece.hpp"
+#include "../core/piecebag.hpp"
+#include "../core/pieces.hpp"
+#include "../core/rng.hpp"
+#include "../core/rollback.hpp"
+#include "../core/timestep.hpp"
+#include "../core/transposition.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Keeps the compiler from optimizing away work whose result goes unused.
+volatile long int sink;
+
+// Fixture sizes.
+const int FILL_LEVELS[] = { 0, 4, 8, 12, 16 };
+const int PROBE_COUNT = 4096;
+const int BOARD_COUNT = 256;
+
+struct BenchResult {
+	std::string name;
+	std::string fixture;
+	double nsPerOp;
+	long int ops;
+};
+
+std::vector<BenchResult> results;
+int repeats = 10;
+
+// Runs `fn` (which does `ops` operations) `repeats` times,
+// and keeps the fastest time.
+template<typename F>
+void measure(const char* name, const std::string& fixture, long int ops, F fn) {
+	double best = 1e30;
+	for (int i = 0; i < repeats; i++) {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		auto end = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+		if (seconds < best) best = seconds;
+	}
+	
+	results.push_back({ name, fixture, best / ops * 1e9, ops });
+	fprintf(stderr, "  %-26s %-14s %10.1f ns/op\n", name, fixture.c_str(), best / ops * 1e9);
+}
+
+// A stack `height` rows tall, with a hole or two in every row
+// (so none of them are full).
+Board makeBoard(Rng& rng, int height) {
+	Board board;
+	for (int y = 0; y < height; y++) {
+		int hole = rng.below(Board::WIDTH);
+		for (int x = 0; x < Board::WIDTH; x++)
+			if (x != hole && rng.below(6) != 0)
+				board.setTile({ x, y }, 1 + rng.below(7));
+	}
+	return board;
+}
+
+// Random pieces in random spots. (Some fit, some don't.)
+std::vector<Piece> makeProbes(Rng& rng) {
+	std::vector<Piece> probes;
+	for (int i = 0; i < PROBE_COUNT; i++) {
+		Piece piece(rng.below(PIECE_COUNT));
+		piece.rotation = rng.below(4);
+		piece.position = { (int)rng.below(Board::WIDTH), (int)rng.below(Board::VISIBLE_HEIGHT + 2) };
+		probes.push_back(piece);
+	}
+	return probes;
+}
+
+// Just the probes that fit on a board.
+std::vector<Piece> keepFitting(const std::vector<Piece>& probes, const Board& board) {
+	std::vector<Piece> fitting;
+	for (const auto& piece : probes)
+		if (piece.fits(board))
+			fitting.push_back(piece);
+	return fitting;
+}
+
+std::string fillName(int height) {
+	return "fill" + std::to_string(height);
+}
+
+void benchPieces(uint64_t seed) {
+	fprintf(stderr, "pieces\n");
+	
+	Rng rng(seed);
+	std::vector<Piece> probes = makeProbes(rng);
+	
+	for (int height : FILL_LEVELS) {
+		Board board = makeBoard(rng, height);
+		std::vector<Piece> fitting = keepFitting(probes, board);
+		std::string fixture = fillName(height);
+		
+		measure("Piece::fits", fixture, probes.size(), [&]{
+			long int n = 0;
+			for (const auto& piece : probes) n += piece.fits(board, { 0, -1 });
+			sink = n;
+		});
+		
+		measure("Piece::fitsAbs", fixture, probes.size(), [&]{
+			long int n = 0;
+			for (const auto& piece : probes) n += piece.fitsAbs(board, piece.position, (piece.rotation + 1) & 3);
+			sink = n;
+		});
+		
+		if (fitting.empty()) continue;
+		
+		measure("Piece::rotate", fixture, fitting.size() * 2, [&]{
+			long int n = 0;
+			for (const auto& piece : fitting) {
+				Piece cw = piece, ccw = piece;
+				n += cw.rotate(board, +1) + ccw.rotate(board, -1);
+			}
+			sink = n;
+		});
+		
+		measure("Piece::getDropYCoord", fixture, fitting.size(), [&]{
+			long int n = 0;
+			for (const auto& piece : fitting) n += piece.getDropYCoord(board);
+			sink = n;
+		});
+	}
+	
+	// Every piece boxed in so tightly that every kick has to be tried,
+	// and every one of them fails.
+	std::vector<Board> boxes;
+	std::vector<Piece> boxed;
+	for (int id = 0; id < PIECE_COUNT; id++) {
+		Piece piece(id);
+		piece.position = { Board::WIDTH / 2, Board::VISIBLE_HEIGHT / 2 };
+		
+		Board board;
+		for (int y = 0; y < Board::HEIGHT; y++)
+			for (int x = 0; x < Board::WIDTH; x++)
+				board.setTile({ x, y }, 1);
+		for (const auto& tile : piece.getTiles())
+			board.setTile(piece.position + tile, 0);
+		
+		Piece test = piece;
+		if (test.rotate(board, +1)) continue; // (like an O piece)
+		boxes.push_back(board);
+		boxed.push_back(piece);
+	}
+	
+	measure("Piece::rotate", "all-kicks-fail", boxed.size(), [&]{
+		long int n = 0;
+		for (size_t i = 0; i < boxed.size(); i++) {
+			Piece piece = boxed[i];
+			n += piece.rotate(boxes[i], +1);
+		}
+		sink = n;
+	});
+}
+
+void benchLineClears(uint64_t seed) {
+	fprintf(stderr, "line clears\n");
+	
+	Rng rng(seed);
+	
+	// An 8-row stack, then `lines` full rows somewhere in its bottom
+	// five (where one piece could have filled them all).
+	for (int lines = 0; lines <= 4; lines++) {
+		std::vector<Board> boards;
+		for (int i = 0; i < BOARD_COUNT; i++) {
+			Board board = makeBoard(rng, 8);
+			int placed = 0;
+			while (placed < lines) {
+				int y = rng.below(PIECE_REACH * 2 + 1);
+				if (board.getRowFill(y) == Board::WIDTH) continue;
+				for (int x = 0; x < Board::WIDTH; x++) board.setTile({ x, y }, 1);
+				placed++;
+			}
+			boards.push_back(board);
+		}
+		
+		std::string fixture = std::to_string(lines) + "-lines";
+		
+		// (Clearing changes the boards, so each run clears fresh copies of
+		//  them. "Board copy" is just the copying, to subtract.)
+		std::vector<Board> work;
+		measure("Board copy", fixture, boards.size(), [&]{
+			work = boards;
+			sink = work.back().tileCount;
+		});
+		
+		measure("Board::removeFilledLines", fixture, boards.size(), [&]{
+			work = boards;
+			long int n = 0;
+			for (auto& board : work) n += board.removeFilledLines();
+			sink = n;
+		});
+		
+		// What the game actually does: only looks at the piece's rows.
+		measure("Board::clearLines", fixture, boards.size(), [&]{
+			work = boards;
+			long int n = 0;
+			for (auto& board : work) n += board.clearLines(0, PIECE_REACH * 2).count;
+			sink = n;
+		});
+	}
+}
+
+void benchBag(uint64_t seed) {
+	fprintf(stderr, "piece bag\n");
+	
+	const int DRAWS = 1 << 16;
+	
+	// Tetrominoes only, and then the biggest range the game ever uses.
+	PieceRange ranges[] = { { 0, 7 }, { 0, 19 } };
+	for (auto range : ranges) {
+		std::string fixture = std::to_string(range.first) + "-" + std::to_string(range.second);
+		
+		PieceBag bag(seed);
+		bag.setPiecesRange(range.first, range.second);
+		measure("PieceBag::getNext", fixture, DRAWS, [&]{
+			long int n = 0;
+			for (int i = 0; i < DRAWS; i++) n += bag.getNext();
+			sink = n;
+		});
+		
+		measure("PieceBag::pushNewSet", fixture, DRAWS / 8, [&]{
+			long int n = 0;
+			for (int i = 0; i < DRAWS / 8; i++) {
+				bag.front = 0; bag.count = 0;
+				bag.pushNewSet();
+				n += bag.peek(0);
+			}
+			sink = n;
+		});
+	}
+	
+	const int LEVELS = 1 << 12;
+	measure("getLevel", "0-63", LEVELS, [&]{
+		long int n = 0;
+		for (int i = 0; i < LEVELS; i++) n += getLevel(i & 63).piecesRange.second;
+		sink = n;
+	});
+}
+
+// Any weights will do, as long as none of them are zero.
+const EvalWeights WEIGHTS = { -0.510066, +0.760666, -0.35663, -0.184483, -0.25, -0.125 };
+
+// The obvious way to score a board: look at every tile, one at a time.
+float scoreNaive(const Board& board, int linesCleared) {
+	auto filled = [&board](int x, int y) {
+		// (Off the sides counts as filled: those are the walls.)
+		return x < 0 || x >= Board::WIDTH || board.getTile({ x, y }) != 0;
+	};
+	
+	int heights[Board::WIDTH] = { 0 };
+	int holes = 0, transitions = 0;
+	for (int x = 0; x < Board::WIDTH; x++) {
+		for (int y = Board::HEIGHT - 1; y >= 0; y--) {
+			if (heights[x] == 0) {
+				if (filled(x, y)) heights[x] = y + 1;
+			} else if (!filled(x, y)) {
+				holes++;
+			}
+		}
+	}
+	for (int y = 0; y < Board::HEIGHT; y++)
+		for (int x = -1; x < Board::WIDTH; x++)
+			if (filled(x, y) != filled(x + 1, y))
+				transitions++;
+	
+	int aggregateHeight = 0, bumpiness = 0, wells = 0;
+	for (int x = 0; x < Board::WIDTH; x++) {
+		aggregateHeight += heights[x];
+		if (x > 0) bumpiness += std::abs(heights[x] - heights[x - 1]);
+		
+		int left  = x > 0 ? heights[x - 1] : Board::HEIGHT;
+		int right = x < Board::WIDTH - 1 ? heights[x + 1] : Board::HEIGHT;
+		int walls = left < right ? left : right;
+		if (walls > heights[x]) wells += walls - heights[x];
+	}
+	
+	return WEIGHTS.height         * aggregateHeight
+	     + WEIGHTS.lines          * linesCleared
+	     + WEIGHTS.holes          * holes
+	     + WEIGHTS.bumpiness      * bumpiness
+	     + WEIGHTS.wells          * wells
+	     + WEIGHTS.rowTransitions * transitions;
+}
+
+// Returns how many boards the kernel and the naive loop disagreed on.
+int benchEvaluation(uint64_t seed) {
+	fprintf(stderr, "board evaluation\n");
+	
+	Rng rng(seed);
+	int mismatches = 0;
+	
+	for (int height : FILL_LEVELS) {
+		std::vector<Board> boards;
+		std::vector<int> lines;
+		for (int i = 0; i < BOARD_COUNT * 4; i++) {
+			boards.push_back(makeBoard(rng, height + rng.below(4)));
+			lines.push_back(rng.below(5));
+		}
+		int boardCount = boards.size();
+		
+		// Boards get packed into batches up front, like the bot does as it goes.
+		int batchCount = (boardCount + BoardBatch::LANES - 1) / BoardBatch::LANES;
+		std::vector<BoardBatch> batches(batchCount);
+		for (int i = 0; i < boardCount; i++)
+			batches[i / BoardBatch::LANES].add(boards[i], lines[i]);
+		
+		std::vector<float> naive(boardCount);
+		std::vector<float> scalar(batchCount * BoardBatch::LANES), batched(scalar.size());
+		std::string fixture = fillName(height);
+		
+		measure("evaluate naive", fixture, boardCount, [&]{
+			for (int i = 0; i < boardCount; i++)
+				naive[i] = scoreNaive(boards[i], lines[i]);
+		});
+		measure("evaluate scalar", fixture, boardCount, [&]{
+			for (int b = 0; b < batchCount; b++)
+				evaluate::scoreBatchScalar(batches[b], WEIGHTS, &scalar[b * BoardBatch::LANES]);
+		});
+		#ifdef __AVX2__
+			const char* kernel = "evaluate AVX2";
+		#else
+			const char* kernel = "evaluate (scalar)";
+		#endif
+		measure(kernel, fixture, boardCount, [&]{
+			for (int b = 0; b < batchCount; b++)
+				scoreBatch(batches[b], WEIGHTS, &batched[b * BoardBatch::LANES]);
+		});
+		
+		for (int i = 0; i < boardCount; i++)
+			if (std::fabs(naive[i] - scalar[i]) > 1e-3 || std::fabs(naive[i] - batched[i]) > 1e-3)
+				mismatches++;
+	}
+	
+	if (mismatches) fprintf(stderr, "  %d evaluation mismatch(es)!\n", mismatches);
+	return mismatches;
+}
+
+void benchMoveGen(uint64_t seed) {
+	fprintf(stderr, "move generator\n");
+	
+	Rng rng(seed);
+	static MoveGenerator generator;
+	
+	for (int height : FILL_LEVELS) {
+		std::vector<Board> boards;
+		for (int i = 0; i < 16; i++) boards.push_back(makeBoard(rng, height));
+		
+		long int ops = boards.size() * PIECE_COUNT;
+		measure("MoveGenerator::generate", fillName(height), ops, [&]{
+			long int n = 0;
+			for (const auto& board : boards)
+				for (int id = 0; id < PIECE_COUNT; id++)
+					n += generator.generate(board, Piece(id));
+			sink = n;
+		});
+	}
+}
+
+// Searches a few pieces deep, without a transposition table, with an empty
+// one, and with one that's already seen the same searches (like the other
+// threads searching the same position would leave it). Then checks that
+// threads sharing one table all at once get the same answers as without.
+// Returns how many answers didn't match.
+int benchLookahead(uint64_t seed) {
+	fprintf(stderr, "lookahead\n");
+	
+	const int SEARCHES = 4;
+	const int MAX_DEPTH = 3;
+	
+	Rng rng(seed);
+	TranspositionTable table(1); // (small, since clearing it gets timed too)
+	LookaheadSearch search;
+	
+	struct Position {
+		Board board;
+		int pieces[MAX_DEPTH];
+		float score;
+	};
+	std::vector<Position> positions;
+	
+	for (int height : { 0, 8 }) {
+		for (int i = 0; i < SEARCHES; i++) {
+			Position position;
+			position.board = makeBoard(rng, height);
+			for (int& id : position.pieces) id = rng.below(PIECE_COUNT);
+			positions.push_back(position);
+		}
+		auto first = positions.end() - SEARCHES;
+		
+		for (int depth = 2; depth <= MAX_DEPTH; depth++) {
+			std::string fixture = fillName(height) + "-depth" + std::to_string(depth);
+			auto searchAll = [&](TranspositionTable* with) {
+				search.table = with;
+				float n = 0;
+				for (auto position = first; position != positions.end(); position++) {
+					position->score = search.search(position->board, Piece(position->pieces[0]),
+						position->pieces + 1, MAX_DEPTH - 1, depth).score;
+					n += position->score;
+				}
+				sink = n;
+			};
+			
+			measure("LookaheadSearch", fixture, SEARCHES, [&]{ searchAll(nullptr); });
+			
+			long int nodes = search.nodes, hits = search.hits;
+			measure("LookaheadSearch cold table", fixture, SEARCHES, [&]{
+				table.clear();
+				searchAll(&table);
+			});
+			fprintf(stderr, "    (%.1f%% of %ld positions found in the table)\n",
+				100.0 * (search.hits - hits) / (search.nodes - nodes), (search.nodes - nodes) / repeats);
+			
+			measure("LookaheadSearch warm table", fixture, SEARCHES, [&]{ searchAll(&table); });
+		}
+	}
+	
+	// Every position at full depth, by several threads at once, all
+	// sharing a table. (Scores were left at full depth by the last runs.)
+	const int THREADS = 4;
+	std::vector<int> threadMismatches(THREADS, 0);
+	table.clear();
+	
+	std::vector<std::thread> threads;
+	for (int t = 0; t < THREADS; t++) {
+		threads.emplace_back([&, t]{
+			LookaheadSearch shared(&table);
+			for (int round = 0; round < 2; round++) {
+				for (size_t i = 0; i < positions.size(); i++) {
+					const Position& position = positions[(i + t) % positions.size()];
+					float score = shared.search(position.board, Piece(position.pieces[0]),
+						position.pieces + 1, MAX_DEPTH - 1, MAX_DEPTH).score;
+					if (score != position.score) threadMismatches[t]++;
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) thread.join();
+	
+	int mismatches = 0;
+	for (int n : threadMismatches) mismatches += n;
+	if (mismatches) fprintf(stderr, "  %d lookahead mismatch(es) with a shared table!\n", mismatches);
+	return mismatches;
+}
+
+// Netplay's rollbacks: saving a snapshot (a plain copy of both games), and
+// restoring one then playing the most frames a rollback ever does again.
+void benchSnapshots(uint64_t seed) {
+	fprintf(stderr, "rollback snapshots\n");
+	
+	// A couple of games some way in, so there's something on the boards.
+	RollbackSession::State state;
+	state.games[0] = Game(seed);
+	state.games[1] = Game(seed + 1);
+	Bot bots[2];
+	for (auto& game : state.games) {
+		InputFrame begin;
+		begin.restart = true;
+		game.step(begin, FixedTimestep::TICK_SECONDS);
+	}
+	for (int i = 0; i < 2000; i++)
+		for (int p = 0; p < 2; p++)
+			state.games[p].step(bots[p].think(state.games[p]), FixedTimestep::TICK_SECONDS);
+	
+	const int COPIES = 1 << 14;
+	std::vector<RollbackSession::State> snapshots(RollbackSession::HISTORY);
+	std::string fixture = std::to_string(sizeof(RollbackSession::State)) + " bytes";
+	measure("State save+restore", fixture, COPIES, [&]{
+		for (int i = 0; i < COPIES; i++) {
+			RollbackSession::State& snapshot = snapshots[i & (RollbackSession::HISTORY - 1)];
+			snapshot = state;
+			state = snapshot;
+		}
+		sink = state.games[0].pieces;
+	});
+	
+	const int ROLLBACKS = 256;
+	InputFrame idle;
+	measure("rollback", std::to_string(RollbackSession::MAX_ROLLBACK) + " frames", ROLLBACKS, [&]{
+		for (int i = 0; i < ROLLBACKS; i++) {
+			RollbackSession::State replayed = snapshots[0];
+			for (int f = 0; f < RollbackSession::MAX_ROLLBACK; f++)
+				for (auto& game : replayed.games) game.step(idle, FixedTimestep::TICK_SECONDS);
+			sink = replayed.games[1].pieces;
+		}
+	});
+}
+
+// Whole bot games, one after another on one thread.
+void benchGames(uint64_t seed, long int targetPieces) {
+	fprintf(stderr, "full games\n");
+	
+	const float STEP_DT = FixedTimestep::TICK_SECONDS;
+	long int pieces = 0, steps = 0;
+	int games = 0;
+	
+	auto start = std::chrono::steady_clock::now();
+	while (pieces < targetPieces) {
+		Game game(seed + games++);
+		Bot bot;
+		
+		InputFrame begin;
+		begin.restart = true;
+		game.step(begin, STEP_DT);
+		
+		while (!game.gameOver && pieces + game.pieces < targetPieces) {
+			game.step(bot.think(game), STEP_DT);
+			steps++;
+		}
+		pieces += game.pieces;
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	
+	results.push_back({ "game", "pieces", seconds / pieces * 1e9, pieces });
+	results.push_back({ "game", "steps", seconds / steps * 1e9, steps });
+	fprintf(stderr, "  %d game(s): %.0f pieces/sec, %.0f steps/sec\n", games, pieces / seconds, steps / seconds);
+}
+
+void writeJson(FILE* file, uint64_t seed) {
+	fprintf(file, "{\n");
+	fprintf(file, "  \"seed\": %llu,\n", (unsigned long long)seed);
+	fprintf(file, "  \"repeats\": %d,\n", repeats);
+	fprintf(file, "  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const auto& r = results[i];
+		fprintf(file, "    { \"name\": \"%s\", \"fixture\": \"%s\", \"ns_per_op\": %.3f, \"ops\": %ld }%s\n",
+			r.name.c_str(), r.fixture.c_str(), r.nsPerOp, r.ops, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n");
+	fprintf(file, "}\n");
+}
+
+int main(int argc, char** argv) {
+	uint64_t seed = 1;
+	const char* outputPath = nullptr;
+	long int gamePieces = 20000;
+	
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if      (!strcmp(argv[i], "-s")) seed = strtoull(argv[i + 1], nullptr, 10);
+		else if (!strcmp(argv[i], "-r")) repeats = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-o")) outputPath = argv[i + 1];
+		else if (!strcmp(argv[i], "-g")) gamePieces = atol(argv[i + 1]);
+		else {
+			printf("usage: %s [-s seed] [-r repeats] [-o results.json] [-g game pieces]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (repeats <= 0) repeats = 1;
+	
+	benchPieces(seed);
+	benchLineClears(seed);
+	benchBag(seed);
+	benchMoveGen(seed);
+	int mismatches = benchEvaluation(seed);
+	mismatches += benchLookahead(seed);
+	benchSnapshots(seed);
+	benchGames(seed, gamePieces);
+	
+	FILE* output = stdout;
+	if (outputPath) {
+		output = fopen(outputPath, "w");
+		if (!output) {
+			fprintf(stderr, "couldn't write %s\n", outputPath);
+			return EXIT_FAILURE;
+		}
+	}
+	writeJson(output, seed);
+	if (output != stdout) fclose(output);
+	
+	return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
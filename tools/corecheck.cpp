@@ -0,0 +1,454 @@
+// Guideline Tetris!!
+// Checks the game core against known answers, and its fast paths against
+// slow but obviously right versions of them. Run by ctest.
+
+// usage: corecheck [-s seed] [-n boards]
+// Prints what it checked, and exits with failure if anything was off.
+
+#include "../core/board.hpp"
+#include "../core/movegen.hpp"
+#include "../core/piece.hpp"
+#include "../core/piecebag.hpp"
+#include "../core/pieces.hpp"
+#include "../core/rng.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <vector>
+
+int failures = 0;
+
+// How many random boards the slow-versus-fast checks go through.
+int boardCount = 400;
+
+// Says what went wrong, and counts it.
+void fail(const char* check, const char* what, long int index, long int got, long int expected) {
+	printf("  %s: %s %ld is %ld, expected %ld\n", check, what, index, got, expected);
+	failures++;
+}
+
+// The same seed has to deal the same pieces everywhere, or replays (and
+// netplay) fall apart between machines. These are what it dealt when this
+// was written; if they change, every old replay is broken.
+void checkRng() {
+	printf("rng\n");
+	
+	const uint32_t EXPECTED_BITS[] = {
+		0x89F4BEFD, 0x94E95A78, 0x7A8293BC, 0xF0F3CCF8, 0x4B9122D4, 0x1E0A0912, 0x56075C69, 0xCD7786E3,
+	};
+	Rng rng(12345);
+	for (int i = 0; i < (int)std::size(EXPECTED_BITS); i++) {
+		uint32_t bits = rng.next();
+		if (bits != EXPECTED_BITS[i]) fail("Rng::next", "number", i, bits, EXPECTED_BITS[i]);
+	}
+	
+	const uint32_t EXPECTED_BELOW[] = { 538, 581, 478, 941, 295, 117, 336, 802 };
+	rng.reseed(12345);
+	for (int i = 0; i < (int)std::size(EXPECTED_BELOW); i++) {
+		uint32_t n = rng.below(1000);
+		if (n != EXPECTED_BELOW[i]) fail("Rng::below", "number", i, n, EXPECTED_BELOW[i]);
+	}
+	
+	// Three sets of tetrominos, and a set of everything.
+	const int EXPECTED_TETROMINOS[] = {
+		1, 4, 0, 5, 2, 6, 3,  5, 0, 1, 6, 3, 4, 2,  5, 0, 6, 1, 2, 3, 4,
+	};
+	PieceBag bag(12345, { 0, 7 });
+	for (int i = 0; i < (int)std::size(EXPECTED_TETROMINOS); i++) {
+		int id = bag.getNext();
+		if (id != EXPECTED_TETROMINOS[i]) fail("PieceBag", "tetromino", i, id, EXPECTED_TETROMINOS[i]);
+	}
+	
+	const int EXPECTED_EVERYTHING[] = {
+		1, 5, 19, 12, 16, 10, 7, 0, 8, 3, 23, 18, 17, 4, 15, 9, 22, 14, 21, 2, 6, 20, 11, 24, 13,
+	};
+	PieceBag everything(12345, { 0, PIECE_COUNT });
+	for (int i = 0; i < (int)std::size(EXPECTED_EVERYTHING); i++) {
+		int id = everything.getNext();
+		if (id != EXPECTED_EVERYTHING[i]) fail("PieceBag", "piece", i, id, EXPECTED_EVERYTHING[i]);
+	}
+}
+
+// `generateSets` has to deal what pushing that many sets would have (and
+// leave the RNG in the same place), without touching the queue.
+void checkGenerateSets() {
+	printf("PieceBag::generateSets\n");
+	
+	const int SETS = 2;
+	for (uint64_t seed = 1; seed <= 100; seed++) {
+		PieceBag generated(seed, { 0, 7 });
+		PieceBag pushed(seed, { 0, 7 });
+		
+		int out[SETS * 7];
+		int written = generated.generateSets(out, SETS);
+		if (written != SETS * 7) fail("generateSets", "count for seed", seed, written, SETS * 7);
+		
+		for (int i = 0; i < SETS; i++) pushed.pushNewSet();
+		for (int i = 0; i < SETS * 7; i++)
+			if (out[i] != pushed.peek(7 + i)) fail("generateSets", "piece", i, out[i], pushed.peek(7 + i));
+		if (memcmp(generated.rng.state, pushed.rng.state, sizeof(generated.rng.state)) != 0)
+			fail("generateSets", "rng state for seed", seed, 0, 1);
+		
+		// The queue's still just the first set.
+		if (generated.size() != 7) fail("generateSets", "queue size for seed", seed, generated.size(), 7);
+		for (int i = 0; i < 7; i++)
+			if (generated.peek(i) != pushed.peek(i)) fail("generateSets", "queued piece", i, generated.peek(i), pushed.peek(i));
+	}
+}
+
+// A messy stack up to 16 rows tall: mostly filled, with holes and
+// overhangs all over, and the odd full row.
+Board makeBoard(Rng& rng) {
+	Board board;
+	int height = rng.below(17);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < Board::WIDTH; x++)
+			if (rng.below(4) != 0)
+				board.setTile({ x, y }, 1 + rng.below(7));
+	return board;
+}
+
+// The tiles a piece covers, in a set that doesn't care which rotation or
+// center got it there.
+std::vector<int> getCoveredTiles(const Piece& piece) {
+	std::vector<int> tiles;
+	for (const auto& tile : piece.getTiles())
+		tiles.push_back((piece.position.y + tile.y) * Board::WIDTH + piece.position.x + tile.x);
+	std::sort(tiles.begin(), tiles.end());
+	return tiles;
+}
+
+// Every placement, the slow way: one move (or one row down) at a time,
+// through `Piece` itself.
+std::set<std::vector<int>> findPlacementsSlowly(const Board& board, const Piece& start) {
+	std::set<std::vector<int>> placements;
+	if (!start.fits(board)) return placements;
+	
+	bool seen[4][Board::HEIGHT][Board::WIDTH] = {};
+	std::vector<Piece> queue = { start };
+	seen[start.rotation][start.position.y][start.position.x] = true;
+	
+	for (size_t next = 0; next < queue.size(); next++) {
+		Piece piece = queue[next];
+		
+		Piece moves[5] = { piece, piece, piece, piece, piece };
+		bool moved[5] = {
+			moves[0].fits(board, { -1, 0 }),
+			moves[1].fits(board, { +1, 0 }),
+			moves[2].rotate(board, +1),
+			moves[3].rotate(board, -1),
+			moves[4].fits(board, { 0, -1 }),
+		};
+		if (moved[0]) moves[0].position.x--;
+		if (moved[1]) moves[1].position.x++;
+		if (moved[4]) moves[4].position.y--;
+		else placements.insert(getCoveredTiles(piece));
+		
+		for (int i = 0; i < 5; i++) {
+			if (!moved[i]) continue;
+			bool& wasSeen = seen[moves[i].rotation][moves[i].position.y][moves[i].position.x];
+			if (wasSeen) continue;
+			wasSeen = true;
+			queue.push_back(moves[i]);
+		}
+	}
+	return placements;
+}
+
+// Plays a path from `getPath` through `Piece`, a move at a time. Returns
+// false if any move doesn't work, or doesn't end up where the path says.
+bool replayPath(const Board& board, Piece piece, const MoveGenerator::PathStep* steps, int count) {
+	for (int i = 0; i < count; i++) {
+		const MoveGenerator::PathStep& step = steps[i];
+		switch (step.move) {
+			case MoveGenerator::LEFT:
+			case MoveGenerator::RIGHT: {
+				int dx = step.move == MoveGenerator::LEFT ? -1 : +1;
+				if (!piece.fits(board, { dx, 0 })) return false;
+				piece.position.x += dx;
+				break;
+			}
+			case MoveGenerator::ROTATE_CW:
+				if (!piece.rotate(board, +1)) return false;
+				break;
+			case MoveGenerator::ROTATE_CCW:
+				if (!piece.rotate(board, -1)) return false;
+				break;
+			case MoveGenerator::SOFT_DROP:
+				// (Could be several rows, but it has to be through open space.)
+				if (piece.position.y <= step.position.y) return false;
+				while (piece.position.y > step.position.y) {
+					if (!piece.fits(board, { 0, -1 })) return false;
+					piece.position.y--;
+				}
+				break;
+		}
+		if (!(piece.position == step.position) || piece.rotation != step.rotation) return false;
+	}
+	return true;
+}
+
+// MoveGenerator (with its soft drops skipping through open space, and
+// placements deduped by their tiles) has to find exactly what the slow
+// search does, for every piece, and every path has to actually get there.
+void checkMoveGenerator(uint64_t seed) {
+	printf("MoveGenerator\n");
+	
+	Rng rng(seed);
+	std::unique_ptr<MoveGenerator> generator(new MoveGenerator);
+	std::unique_ptr<MoveGenerator::PathStep[]> steps(new MoveGenerator::PathStep[MoveGenerator::STATE_COUNT]);
+	long int placementsChecked = 0;
+	
+	for (int b = 0; b < boardCount; b++) {
+		Board board = makeBoard(rng);
+		for (int id = 0; id < PIECE_COUNT; id++) {
+			Piece piece(id);
+			int count = generator->generate(board, piece);
+			std::set<std::vector<int>> expected = findPlacementsSlowly(board, piece);
+			
+			std::set<std::vector<int>> found;
+			for (int i = 0; i < count; i++) {
+				const MoveGenerator::Placement& placement = generator->placements[i];
+				Piece placed = piece;
+				placed.position = placement.position;
+				placed.rotation = placement.rotation;
+				found.insert(getCoveredTiles(placed));
+				
+				int length = generator->getPath(placement, steps.get(), MoveGenerator::STATE_COUNT);
+				bool landed = replayPath(board, piece, steps.get(), length)
+					&& (length == 0 || (steps[length - 1].position == placement.position && steps[length - 1].rotation == placement.rotation))
+					&& !placed.fits(board, { 0, -1 });
+				if (!landed) fail("MoveGenerator", "path on board", b, id, -1);
+			}
+			placementsChecked += count;
+			
+			if ((int)found.size() != count) fail("MoveGenerator", "duplicate placements on board", b, count, found.size());
+			if (found != expected) fail("MoveGenerator", "placements on board", b, found.size(), expected.size());
+		}
+	}
+	printf("  %ld placements on %d boards\n", placementsChecked, boardCount);
+}
+
+// Works out every one of the board's running stats (and its hash, and its
+// row masks) from its tiles, and says which ones don't match. Returns how
+// many didn't.
+int checkAgainstRescan(const Board& board, long int step) {
+	int problems = 0;
+	auto mismatch = [&](const char* what, long int index, long int got, long int expected) {
+		if (problems++ < 5) fail("Board stats", what, index, got, expected);
+		else failures++;
+	};
+	
+	int heights[Board::WIDTH] = {};
+	int fills[Board::HEIGHT] = {};
+	int tiles = 0;
+	uint64_t hash = 0;
+	for (int y = 0; y < Board::HEIGHT; y++) {
+		uint16_t mask = Board::EMPTY_ROW;
+		for (int x = 0; x < Board::WIDTH; x++) {
+			if (!board.board[y][x]) continue;
+			heights[x] = y + 1;
+			fills[y]++;
+			tiles++;
+			hash ^= zobrist::tile(y, x);
+			mask |= 1 << (x + Board::WALL_BITS);
+		}
+		if (board.getRowMask(y) != mask) mismatch("row mask of row", y, board.getRowMask(y), mask);
+		if (board.getRowFill(y) != fills[y]) mismatch("fill of row", y, board.getRowFill(y), fills[y]);
+	}
+	
+	int maxHeight = 0, heightSum = 0;
+	for (int x = 0; x < Board::WIDTH; x++) {
+		if (board.getColumnHeight(x) != heights[x]) mismatch("height of column", x, board.getColumnHeight(x), heights[x]);
+		maxHeight = std::max(maxHeight, heights[x]);
+		heightSum += heights[x];
+	}
+	if (board.getMaxHeight() != maxHeight) mismatch("max height at step", step, board.getMaxHeight(), maxHeight);
+	if (board.getHeightSum() != heightSum) mismatch("height sum at step", step, board.getHeightSum(), heightSum);
+	if (board.tileCount != tiles) mismatch("tile count at step", step, board.tileCount, tiles);
+	if (board.hash != hash) mismatch("hash at step", step, 0, 1);
+	return problems;
+}
+
+// Every way of changing a board has to keep its running stats (see
+// board.hpp) the same as counting them all over again would: piles of
+// pieces, odd tiles in and out, lines cleared and removed, and garbage.
+void checkBoardStats(uint64_t seed) {
+	printf("Board stats\n");
+	
+	Rng rng(seed);
+	Board board;
+	long int steps = boardCount * 500L;
+	for (long int step = 0; step < steps; step++) {
+		int what = rng.below(100);
+		if (what < 40) {
+			Piece piece(rng.below(PIECE_COUNT));
+			piece.rotation = rng.below(4);
+			piece.position.x = rng.below(Board::WIDTH);
+			if (piece.fits(board)) {
+				piece.position.y = piece.searchDropYCoord(board);
+				piece.place(board);
+				board.clearLines(piece.position.y - PIECE_REACH, piece.position.y + PIECE_REACH);
+			}
+		} else if (what < 65) {
+			int color = rng.below(3) == 0 ? 0 : 1 + rng.below(7);
+			board.setTile({ (int)rng.below(Board::WIDTH), (int)rng.below(Board::HEIGHT) }, color);
+		} else if (what < 75) {
+			board.removeLine(rng.below(Board::HEIGHT));
+		} else if (what < 85) {
+			board.addGarbage(1 + rng.below(4), rng.below(Board::WIDTH), GARBAGE_TILE);
+		} else if (what < 95) {
+			board.removeFilledLines();
+		} else if (what < 96 || board.getMaxHeight() > 24) {
+			board.clear();
+		}
+		
+		// (Just the first few problems, not one for every step after.)
+		if (checkAgainstRescan(board, step) && failures > 20) break;
+	}
+	printf("  %ld steps\n", steps);
+}
+
+// Clears lines the old way: one at a time, from the top down (so the rows
+// still to look at don't move), bringing everything above down each time.
+LineClear clearLinesSlowly(Board& board, int bottom, int top) {
+	LineClear cleared;
+	for (int y = std::min(top, Board::HEIGHT - 1); y >= std::max(bottom, 0); y--) {
+		if (!board.isLineFilled(y)) continue;
+		board.removeLine(y);
+		cleared.rows |= 1u << y;
+		cleared.count++;
+	}
+	return cleared;
+}
+
+bool sameTiles(const Board& a, const Board& b) {
+	return memcmp(a.board, b.board, sizeof(a.board)) == 0;
+}
+
+// `clearLines` does it all in one pass, and has to come out the same as
+// clearing a line at a time: lots of full rows, next to each other or not,
+// in any window. And only the rows a piece could reach from its center get
+// looked at after it lands, which is only right if pieces really can't
+// reach any further (in any rotation).
+void checkLineClears(uint64_t seed) {
+	printf("Board::clearLines\n");
+	
+	for (int id = 0; id < BUILT_IN_PIECE_SET.count; id++)
+		for (int r = 0; r < 4; r++)
+			for (const auto& tile : BUILT_IN_PIECE_SET.getShape(id).getTiles(r))
+				if (std::abs(tile.x) > PIECE_REACH || std::abs(tile.y) > PIECE_REACH)
+					fail("PIECE_REACH", "tile row of piece", id, tile.y, PIECE_REACH);
+	
+	Rng rng(seed);
+	long int rounds = boardCount * 50L, linesChecked = 0, pieceLines = 0;
+	for (long int round = 0; round < rounds; round++) {
+		// Every row's either full, or has a hole or a few. (When a piece is
+		// going to land, just the one, so it's got a chance of filling some.)
+		Board board;
+		int height = rng.below(Board::HEIGHT + 1);
+		bool fullRows = round % 2 == 0;
+		for (int y = 0; y < height; y++) {
+			bool full = fullRows && rng.below(3) == 0;
+			int hole = rng.below(Board::WIDTH);
+			for (int x = 0; x < Board::WIDTH; x++)
+				if (full || (x != hole && (!fullRows || rng.below(5) != 0)))
+					board.setTile({ x, y }, 1 + rng.below(7));
+		}
+		
+		Board fast = board, slow = board;
+		int bottom, top;
+		if (fullRows) {
+			// Somewhere (maybe even off the board) to clear between.
+			bottom = (int)rng.below(Board::HEIGHT + 4) - 2;
+			top = bottom + rng.below(Board::HEIGHT + 2);
+		} else {
+			// A piece lands, and only its rows get looked at. But the slow way
+			// looks at the whole board, so it'd see anything else that filled.
+			Piece piece(rng.below(PIECE_COUNT));
+			piece.rotation = rng.below(4);
+			piece.position.x = rng.below(Board::WIDTH);
+			piece.position.y = Board::HEIGHT - 1 - PIECE_REACH;
+			if (!piece.fits(board)) continue;
+			piece.position.y = piece.searchDropYCoord(board);
+			piece.place(fast);
+			piece.place(slow);
+			bottom = piece.position.y - PIECE_REACH;
+			top = piece.position.y + PIECE_REACH;
+		}
+		
+		LineClear fastClear = fast.clearLines(bottom, top);
+		LineClear slowClear = fullRows ? clearLinesSlowly(slow, bottom, top) : clearLinesSlowly(slow, 0, Board::HEIGHT - 1);
+		linesChecked += slowClear.count;
+		if (!fullRows) pieceLines += slowClear.count;
+		
+		if (fastClear.count != slowClear.count) fail("clearLines", "count in round", round, fastClear.count, slowClear.count);
+		if (fastClear.rows != slowClear.rows) fail("clearLines", "rows in round", round, fastClear.rows, slowClear.rows);
+		if (!sameTiles(fast, slow)) fail("clearLines", "tiles in round", round, 0, 1);
+		checkAgainstRescan(fast, round);
+		if (failures > 20) break;
+	}
+	printf("  %ld lines on %ld boards (%ld by pieces landing)\n", linesChecked, rounds, pieceLines);
+}
+
+// Hard drops (and the ghost piece) go by the columns' heights, falling
+// back to searching when the piece is tucked under something. Either way,
+// it has to land where moving it down a row at a time would.
+void checkDropY(uint64_t seed) {
+	printf("Piece::getDropYCoord\n");
+	
+	Rng rng(seed);
+	long int drops = 0, tucked = 0;
+	for (int b = 0; b < boardCount; b++) {
+		// Full of holes, so there's room to tuck into.
+		Board board = makeBoard(rng);
+		for (int y = 0; y < board.getMaxHeight(); y++)
+			for (int x = 0; x < Board::WIDTH; x++)
+				if (rng.below(2)) board.setTile({ x, y }, 0);
+		
+		for (int i = 0; i < 200; i++) {
+			// Anywhere at all it fits, under overhangs too.
+			Piece piece(rng.below(PIECE_COUNT));
+			piece.rotation = rng.below(4);
+			piece.position = { (int)rng.below(Board::WIDTH), (int)rng.below(Board::HEIGHT) };
+			if (!piece.fits(board)) continue;
+			
+			int expected = piece.position.y;
+			while (piece.fitsAbs(board, { piece.position.x, expected - 1 })) expected--;
+			
+			int y = piece.getDropYCoord(board);
+			if (y != expected) fail("getDropYCoord", "landing row on board", b, y, expected);
+			drops++;
+			if (piece.position.y < board.getMaxHeight()) tucked++;
+		}
+	}
+	printf("  %ld drops (%ld from under the top of the stack)\n", drops, tucked);
+}
+
+int main(int argc, char** argv) {
+	uint64_t seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if      (!strcmp(argv[i], "-s")) seed = strtoull(argv[i + 1], nullptr, 10);
+		else if (!strcmp(argv[i], "-n")) boardCount = atoi(argv[i + 1]);
+		else {
+			printf("usage: %s [-s seed] [-n boards]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	
+	checkRng();
+	checkGenerateSets();
+	checkMoveGenerator(seed);
+	checkBoardStats(seed);
+	checkLineClears(seed);
+	checkDropY(seed);
+	
+	if (failures) printf("%d check(s) FAILED\n", failures);
+	else printf("all ok\n");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+// Guideline Tetris!!
+// Turns files into a header of byte arrays, so they can be baked into the
+// game instead of sitting next to it. (A portable stand-in for `xxd -i`.)
+
+// usage: embed out.hpp NAME file [NAME file...]
+// Each file becomes `NAME[]` and `NAME_SIZE`.
+
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+	if (argc < 4 || argc % 2 != 0) {
+		printf("usage: %s out.hpp NAME file [NAME file...]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	
+	FILE* out = fopen(argv[1], "w");
+	if (!out) {
+		printf("couldn't write %s!\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	
+	fprintf(out, "// Generated by tools/embed.cpp. Don't edit, and don't commit.\n\n");
+	fprintf(out, "#pragma once\n\n#include <cstddef>\n");
+	
+	for (int i = 2; i < argc; i += 2) {
+		const char* name = argv[i];
+		const char* path = argv[i + 1];
+		
+		FILE* in = fopen(path, "rb");
+		if (!in) {
+			printf("couldn't read %s!\n", path);
+			fclose(out);
+			remove(argv[1]);
+			return EXIT_FAILURE;
+		}
+		
+		fprintf(out, "\n// %s\nalignas(16) const unsigned char %s[] = {", path, name);
+		
+		size_t size = 0;
+		unsigned char buffer[1 << 16];
+		size_t got;
+		while ((got = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+			for (size_t b = 0; b < got; b++, size++)
+				fprintf(out, "%s%u,", size % 24 == 0 ? "\n\t" : "", buffer[b]);
+		}
+		fclose(in);
+		
+		// (Arrays can't be empty.)
+		if (size == 0) fprintf(out, "0");
+		fprintf(out, "\n};\nconst size_t %s_SIZE = %zu;\n", name, size);
+	}
+	
+	if (fclose(out) != 0) {
+		printf("couldn't finish writing %s!\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,215 @@
+// Guideline Tetris!!
+// Netplay loopback test: two bots play each other over real UDP sockets on
+// localhost, through a fake bad network, then both sides' games get checked
+// against each other and against the same inputs played with no network.
+// (And every frame's advance, rollbacks and all, has to fit in a frame.)
+
+// usage: netplay [-f frames] [-l latency ms] [-j jitter ms] [-p loss %] [-a bot actions/sec] [-s seed]
+// Time is simulated (one tick per loop), so this runs as fast as it can,
+// but the sockets are real.
+
+#include "../core/bot.hpp"
+#include "../core/netplay.hpp"
+#include "../core/rollback.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Enough of a game's state to tell if two copies of it have gone different.
+uint64_t hashGame(const Game& game) {
+	uint64_t hash = 0xCBF29CE484222325;
+	auto mix = [&hash](uint64_t value) {
+		for (int i = 0; i < 8; i++) {
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 0x100000001B3;
+		}
+	};
+	for (int y = 0; y < Board::HEIGHT; y++)
+		for (int x = 0; x < Board::WIDTH; x++)
+			mix(game.board.board[y][x]);
+	mix(game.score); mix(game.lines); mix(game.pieces); mix(game.gameOver);
+	mix(game.piece.position.x); mix(game.piece.position.y); mix(game.piece.rotation);
+	mix(game.garbageQueued); mix(game.bag.front); mix(game.bag.count);
+	return hash;
+}
+
+// One side: its link, its session, and the bot at its keyboard.
+struct Side {
+	NetplayLink link;
+	std::unique_ptr<RollbackSession> session;
+	Bot bot;
+	float sinceAction = 0;
+	InputFrame input;
+	
+	// Every input this side ran, by frame, for checking afterwards.
+	std::vector<uint16_t> played;
+	
+	long int stalls = 0, waits = 0;
+	double worstAdvance = 0, totalAdvance = 0;
+	long int advances = 0;
+};
+
+int main(int argc, char** argv) {
+	uint32_t frames = FixedTimestep::TICK_RATE * 60;
+	double latency = 0.040, jitter = 0.020;
+	float loss = 0.05;
+	float actionsPerSecond = 10;
+	uint64_t seed = 1;
+	
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if      (!strcmp(argv[i], "-f")) frames = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-l")) latency = atof(argv[i + 1]) / 1000;
+		else if (!strcmp(argv[i], "-j")) jitter = atof(argv[i + 1]) / 1000;
+		else if (!strcmp(argv[i], "-p")) loss = atof(argv[i + 1]) / 100;
+		else if (!strcmp(argv[i], "-a")) actionsPerSecond = atof(argv[i + 1]);
+		else if (!strcmp(argv[i], "-s")) seed = strtoull(argv[i + 1], nullptr, 10);
+		else {
+			printf("usage: %s [-f frames] [-l latency ms] [-j jitter ms] [-p loss %%] [-a bot actions/sec] [-s seed]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	
+	// Sockets first, on whatever ports are free, then point them at each other.
+	Side sides[2];
+	UdpAddress localhost;
+	if (!localhost.resolve("127.0.0.1", 0)) {
+		printf("couldn't resolve localhost\n");
+		return EXIT_FAILURE;
+	}
+	for (int p = 0; p < 2; p++) {
+		if (!sides[p].link.open(0, localhost, p, p == 0 ? seed : 0)) {
+			printf("couldn't open a socket\n");
+			return EXIT_FAILURE;
+		}
+		LossyLink& shim = sides[p].link.shim;
+		shim.lossRate = loss;
+		shim.latency = latency;
+		shim.jitter = jitter;
+		shim.rng.reseed(seed * 2 + p);
+	}
+	sides[0].link.peer.port = sides[1].link.socket.getPort();
+	sides[1].link.peer.port = sides[0].link.socket.getPort();
+	
+	const double TICK = FixedTimestep::TICK_SECONDS;
+	double now = 0;
+	
+	// Say hello.
+	bool connected = false;
+	for (int tick = 0; !connected; tick++) {
+		if (tick * TICK > NetplayLink::TIMEOUT) {
+			printf("couldn't connect\n");
+			return EXIT_FAILURE;
+		}
+		now += TICK;
+		connected = true;
+		for (auto& side : sides) connected &= side.link.connect(now);
+	}
+	for (int p = 0; p < 2; p++)
+		sides[p].session.reset(new RollbackSession(p, sides[p].link.seed, BUILT_IN_PIECE_SET));
+	printf("connected after %.3f s (seed %llu)\n", now, (unsigned long long)sides[1].link.seed);
+	
+	// Play until both sides have run every frame, and have heard every input.
+	using Clock = std::chrono::steady_clock;
+	for (;;) {
+		now += TICK;
+		
+		bool done = true;
+		for (auto& side : sides) {
+			RollbackSession& session = *side.session;
+			if (!side.link.receiveInputs(session, now)) {
+				printf("lost connection\n");
+				return EXIT_FAILURE;
+			}
+			
+			if (session.frame < frames) {
+				// The bot only gets to press something every so often, and
+				// whatever it pressed sticks around until a frame runs.
+				side.sinceAction += TICK;
+				if (side.sinceAction >= 1 / actionsPerSecond) {
+					side.sinceAction = 0;
+					InputFrame pressed = side.bot.think(session.getLocalGame());
+					side.input.dx = pressed.dx;
+					side.input.rotate = pressed.rotate;
+					side.input.hardDrop = pressed.hardDrop;
+				}
+				
+				if (session.shouldWait()) {
+					side.waits++;
+				} else {
+					auto start = Clock::now();
+					bool advanced = session.advance(side.input);
+					double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+					
+					if (advanced) {
+						side.played.push_back(side.input.pack());
+						side.input.clearTaps();
+						side.totalAdvance += seconds;
+						side.advances++;
+						if (seconds > side.worstAdvance) side.worstAdvance = seconds;
+					} else {
+						side.stalls++;
+					}
+				}
+			} else {
+				session.rollBack();
+			}
+			
+			side.link.sendInputs(session, now);
+			done &= session.frame == frames && session.remoteConfirmed == frames && session.rollbackFrom == RollbackSession::NO_ROLLBACK;
+		}
+		if (done) break;
+		
+		if (now > frames * TICK * 10 + NetplayLink::TIMEOUT) {
+			printf("never finished\n");
+			return EXIT_FAILURE;
+		}
+	}
+	
+	// The same inputs again, with no network and no guessing.
+	RollbackSession::State reference;
+	reference.games[0] = Game(seed, BUILT_IN_PIECE_SET);
+	reference.games[1] = Game(seed + 1, BUILT_IN_PIECE_SET);
+	for (auto& game : reference.games) game.restart();
+	for (uint32_t f = 0; f < frames; f++) {
+		for (int p = 0; p < 2; p++)
+			reference.games[p].step(InputFrame::unpack(sides[p].played[f]), FixedTimestep::TICK_SECONDS);
+		Game& a = reference.games[0];
+		Game& b = reference.games[1];
+		a.garbageQueued += b.garbageToSend;
+		b.garbageQueued += a.garbageToSend;
+		a.garbageToSend = b.garbageToSend = 0;
+	}
+	
+	printf("%u frames (%.1f s of play) in %.1f s of simulated time, %.0f ms latency, %.0f ms jitter, %.0f%% loss\n",
+		frames, frames * TICK, now, latency * 1000, jitter * 1000, loss * 100);
+	for (int p = 0; p < 2; p++) {
+		const Side& side = sides[p];
+		const RollbackSession& session = *side.session;
+		printf("  player %d: %ld rollbacks, %ld frames redone (at most %d at once), %ld stalls, %ld waits\n",
+			p, session.rollbacks, session.framesResimulated, session.maxRollbackFrames, side.stalls, side.waits);
+		printf("            advance: %.1f us on average, %.1f us at worst (a frame is %.0f us)\n",
+			side.totalAdvance / side.advances * 1e6, side.worstAdvance * 1e6, TICK * 1e6);
+		printf("            score %ld, lines %d, pieces %ld%s\n", session.state.games[p].score,
+			session.state.games[p].lines, session.state.games[p].pieces, session.state.games[p].gameOver ? " (topped out)" : "");
+	}
+	
+	bool ok = true;
+	for (int p = 0; p < 2; p++) {
+		uint64_t expected = hashGame(reference.games[p]);
+		for (const auto& side : sides) ok &= hashGame(side.session->state.games[p]) == expected;
+	}
+	printf("%s\n", ok ? "both sides match" : "DESYNC");
+	
+	// Rolling back (restoring a snapshot and playing up to MAX_ROLLBACK
+	// frames again) has to fit in a frame, or it'd drop them.
+	for (int p = 0; p < 2; p++) {
+		if (sides[p].worstAdvance <= TICK) continue;
+		printf("player %d: an advance took longer than a frame!\n", p);
+		ok = false;
+	}
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Guideline Tetris!!
+# Two-stage profile-guided build: build instrumented, let the bot play a
+# pile of seeded games (in the game itself and in the headless runner), then
+# build again using what that measured.
+#
+# usage: tools/pgo.sh [build dir] [extra cmake args...]
+# (Both stages have to share a build directory, since GCC's profiles are
+# matched up by object file path.)
+
+set -e
+
+SOURCE_DIR=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_DIR=${1:-"$SOURCE_DIR/build-pgo"}
+[ $# -gt 0 ] && shift
+PROFILE_DIR="$BUILD_DIR/pgo-profiles"
+
+# How much training to do. The same seeds every time, so builds are repeatable.
+GAMES=${PGO_GAMES:-200}
+
+echo "== stage 1: instrumented build"
+rm -rf "$PROFILE_DIR"
+cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" -D PGO=GENERATE -D PGO_DIR="$PROFILE_DIR" "$@"
+cmake --build "$BUILD_DIR" --parallel
+
+echo "== training"
+"$BUILD_DIR/runner" -n "$GAMES" -s 1
+"$BUILD_DIR/bench" -r 1 -g 2000 -o /dev/null
+if [ -x "$BUILD_DIR/tetris" ]; then
+	"$BUILD_DIR/tetris" --selfplay "$GAMES"
+fi
+
+# Clang writes raw profiles, which need merging first. (GCC's are ready.)
+if ls "$PROFILE_DIR"/*.profraw > /dev/null 2>&1; then
+	llvm-profdata merge -o "$PROFILE_DIR/merged.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+echo "== stage 2: optimized build"
+cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" -D PGO=USE -D PGO_DIR="$PROFILE_DIR" "$@"
+cmake --build "$BUILD_DIR" --parallel --clean-first
+
+echo "== done, in $BUILD_DIR"
@@ -0,0 +1,82 @@
+// Guideline Tetris!!
+// Replay checker: plays back lots of replays across every core, as fast as
+// possible, and reports any that don't end up where they say they should.
+
+// usage: replaycheck [-j threads] [-q] [-p pieces] file...
+// Replays recorded with a piece set file (the game's --pieces) need the same
+// file here. Exits with failure if any replay couldn't be read, was recorded
+// with other pieces, or didn't match.
+
+#include "../core/pieceset.hpp"
+#include "../core/replay.hpp"
+#include "../core/worksteal.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char** argv) {
+	int threads = 0;
+	bool quiet = false;
+	const char* piecesPath = nullptr;
+	std::vector<const char*> paths;
+	
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc) threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-q")) quiet = true;
+		else if (!strcmp(argv[i], "-p") && i + 1 < argc) piecesPath = argv[++i];
+		else if (argv[i][0] == '-') {
+			printf("usage: %s [-j threads] [-q] [-p pieces] file...\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+		else paths.push_back(argv[i]);
+	}
+	
+	PieceSet pieceSet = BUILT_IN_PIECE_SET;
+	char pieceError[256];
+	if (piecesPath && !pieceSet.load(piecesPath, pieceError, sizeof(pieceError))) {
+		printf("couldn't load pieces: %s\n", pieceError);
+		return EXIT_FAILURE;
+	}
+	if (paths.empty()) return EXIT_SUCCESS;
+	
+	WorkStealingPool pool(threads);
+	
+	std::vector<ReplayCheck> checks(paths.size());
+	auto check = [&](int index, int) {
+		checks[index] = checkReplay(paths[index], pieceSet);
+	};
+	
+	auto start = std::chrono::steady_clock::now();
+	pool.run(paths.size(), check);
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	
+	int bad = 0;
+	uint64_t totalFrames = 0;
+	for (size_t i = 0; i < paths.size(); i++) {
+		const ReplayCheck& c = checks[i];
+		totalFrames += c.frames;
+		
+		if (!c.readable) {
+			printf("%s: unreadable\n", paths[i]);
+			bad++;
+		} else if (!c.rightPieces) {
+			printf("%s: recorded with other pieces (see -p)\n", paths[i]);
+			bad++;
+		} else if (!c.matches) {
+			printf("%s: MISMATCH score %lld (expected %lld), lines %d (expected %d)\n", paths[i],
+				(long long)c.score, (long long)c.expectedScore, c.lines, c.expectedLines);
+			bad++;
+		} else if (!quiet) {
+			printf("%s: ok, score %lld, lines %d\n", paths[i], (long long)c.score, c.lines);
+		}
+	}
+	
+	printf("%zu replays (%d bad) on %d threads in %.3f s, %.0f frames/sec\n",
+		paths.size(), bad, pool.getThreadCount(), seconds, totalFrames / seconds);
+	
+	return bad ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+// Guideline Tetris!!
+// Headless batch runner: plays lots of bot games across every core,
+// then prints how fast that went and how well the bot did.
+
+// usage: runner [-n games] [-s seed] [-j threads] [-p max pieces per game] [-r replay dir]
+//               [-m planning ms per piece [-d horizon] [-t table MB]]
+// Game `i` is seeded with `seed + i`, so any single game can be replayed.
+// With -r, every game also gets recorded to `<dir>/<seed>.ntr`.
+// With -m, the bots plan every piece with MonteCarloPlanner, sampling
+// `horizon` pieces ahead for that long. The games go one at a time then,
+// since the planner's using every thread.
+
+#include "../core/bot.hpp"
+#include "../core/game.hpp"
+#include "../core/planner.hpp"
+#include "../core/replay.hpp"
+#include "../core/timestep.hpp"
+#include "../core/transposition.hpp"
+#include "../core/worksteal.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// One fixed simulation step, the same as the game's (see timestep.hpp), so
+// the numbers here describe the game people actually play.
+const float STEP_DT = FixedTimestep::TICK_SECONDS;
+
+struct GameResult {
+	long int score;
+	int lines;
+	long int pieces;
+	long int steps;
+};
+
+// Plays one game from start to game over (or until `maxPieces`).
+// Everything it touches lives on its own stack.
+// If `replay` is open, every step gets recorded into it too.
+// With a `planner`, it picks the bot's spots.
+GameResult playGame(uint64_t seed, long int maxPieces, ReplayWriter* replay = nullptr, MonteCarloPlanner* planner = nullptr) {
+	Game game(seed);
+	Bot bot;
+	
+	InputFrame start;
+	start.restart = true;
+	game.step(start, STEP_DT);
+	if (replay) replay->record(start, STEP_DT);
+	
+	long int steps = 1;
+	while (!game.gameOver && game.pieces < maxPieces) {
+		if (planner && bot.plannedFor != game.pieces) {
+			MonteCarloPlanner::Choice choice = planner->plan(game);
+			if (choice.found) bot.follow(game, choice.rotation, choice.x);
+		}
+		InputFrame input = bot.think(game);
+		game.step(input, STEP_DT);
+		if (replay) replay->record(input, STEP_DT);
+		steps++;
+	}
+	
+	if (replay) replay->finish(game);
+	
+	return { game.score, game.lines, game.pieces, steps };
+}
+
+// Prints min/mean/percentiles/max of some numbers.
+void printDistribution(const char* name, std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	
+	double sum = 0;
+	for (double v : values) sum += v;
+	
+	auto percentile = [&values](double p) {
+		return values[(size_t)(p * (values.size() - 1) + 0.5)];
+	};
+	
+	printf("  %-7s min %10.0f  mean %10.1f  p10 %10.0f  p50 %10.0f  p90 %10.0f  max %10.0f\n",
+		name, values.front(), sum / values.size(),
+		percentile(0.1), percentile(0.5), percentile(0.9), values.back());
+}
+
+int main(int argc, char** argv) {
+	int games = 1000;
+	uint64_t seed = 1;
+	int threads = 0;
+	long int maxPieces = 2000;
+	const char* replayDir = nullptr;
+	double planningMs = 0;
+	int horizon = 8;
+	int tableMegabytes = 64;
+	
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if      (!strcmp(argv[i], "-n")) games = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-s")) seed = strtoull(argv[i + 1], nullptr, 10);
+		else if (!strcmp(argv[i], "-j")) threads = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-p")) maxPieces = atol(argv[i + 1]);
+		else if (!strcmp(argv[i], "-r")) replayDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-m")) planningMs = atof(argv[i + 1]);
+		else if (!strcmp(argv[i], "-d")) horizon = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-t")) tableMegabytes = atoi(argv[i + 1]);
+		else {
+			printf("usage: %s [-n games] [-s seed] [-j threads] [-p max pieces] [-r replay dir] [-m planning ms [-d horizon] [-t table MB]]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (games <= 0) return EXIT_SUCCESS;
+	
+	WorkStealingPool pool(threads);
+	
+	// Planning (if any) gets the whole pool, and its own table.
+	std::unique_ptr<TranspositionTable> table;
+	std::unique_ptr<MonteCarloPlanner> planner;
+	if (planningMs > 0) {
+		table.reset(new TranspositionTable(tableMegabytes));
+		planner.reset(new MonteCarloPlanner(pool, seed, table.get()));
+		planner->budget = planningMs / 1000;
+		planner->horizon = horizon;
+	}
+	
+	// Each game only ever writes its own slot.
+	std::vector<GameResult> results(games);
+	auto play = [&](int index, int) {
+		if (!replayDir) {
+			results[index] = playGame(seed + index, maxPieces, nullptr, planner.get());
+			return;
+		}
+		
+		char path[1024];
+		snprintf(path, sizeof(path), "%s/%llu.ntr", replayDir, (unsigned long long)(seed + index));
+		
+		// (Too big to want on the stack of every worker.)
+		std::unique_ptr<ReplayWriter> replay(new ReplayWriter);
+		if (!replay->open(path, seed + index))
+			printf("couldn't write %s\n", path);
+		results[index] = playGame(seed + index, maxPieces, replay.get(), planner.get());
+	};
+	
+	auto start = std::chrono::steady_clock::now();
+	if (planner) {
+		for (int i = 0; i < games; i++) play(i, 0);
+	} else {
+		pool.run(games, play);
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	
+	long int totalPieces = 0, totalSteps = 0;
+	std::vector<double> scores, lines, pieces;
+	for (const auto& result : results) {
+		totalPieces += result.pieces;
+		totalSteps += result.steps;
+		scores.push_back(result.score);
+		lines.push_back(result.lines);
+		pieces.push_back(result.pieces);
+	}
+	
+	printf("%d games on %d threads in %.3f s\n", games, pool.getThreadCount(), seconds);
+	printf("  %.1f games/sec, %.0f pieces/sec, %.0f steps/sec (%.0fx real time)\n",
+		games / seconds, totalPieces / seconds, totalSteps / seconds,
+		totalSteps * STEP_DT / seconds);
+	printDistribution("score", scores);
+	printDistribution("lines", lines);
+	printDistribution("pieces", pieces);
+	
+	if (planner) {
+		printf("  planning: %.1f samples/piece, %.1f%% of playout positions found in the table\n",
+			(double)planner->samples / planner->plans, 100.0 * planner->tableHits / planner->playouts);
+	}
+	
+	return EXIT_SUCCESS;
+}